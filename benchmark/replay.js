@@ -0,0 +1,145 @@
+const dgram = require('dgram');
+const fs = require('fs');
+
+// Replays datagrams a server received, as recorded by UDP.startCapture(socket, path, 'native'),
+// against a server build and reports throughput and request/response latency.
+//
+//   node benchmark/replay.js <capture> [host] [port] [--fast] [--speed=N]
+
+const CAPTURE_MAGIC = 'NSCAP001';
+const RECORD_HEADER_SIZE = 32;
+const DIRECTION_RECEIVED = 0;
+const MAX_SOCKETS = 1024;
+const DRAIN_TIME = 1000;
+
+const args = process.argv.slice(2).filter((arg) => !arg.startsWith('--'));
+const flags = process.argv.slice(2).filter((arg) => arg.startsWith('--'));
+const CAPTURE = args[0];
+const HOST = args[1] || '127.0.0.1';
+const PORT = Number(args[2] || 5001);
+const FAST = flags.includes('--fast');
+const SPEED = Number((flags.find((flag) => flag.startsWith('--speed=')) || '--speed=1').split('=')[1]);
+
+function readCapture(path) {
+  const data = fs.readFileSync(path);
+
+  if (data.toString('latin1', 0, CAPTURE_MAGIC.length) !== CAPTURE_MAGIC)
+    throw new Error(`${path} is not a native capture file`);
+
+  const records = [];
+  let offset = CAPTURE_MAGIC.length;
+
+  while (offset + RECORD_HEADER_SIZE <= data.length) {
+    const timestamp = data.readBigUInt64LE(offset);
+
+    if (timestamp === 0n)
+      break;
+
+    const direction = data[offset + 8];
+    const port = data.readUInt16LE(offset + 10);
+    const ip = data.toString('hex', offset + 12, offset + 28);
+    const length = data.readUInt32LE(offset + 28);
+    const payload = data.subarray(offset + RECORD_HEADER_SIZE, offset + RECORD_HEADER_SIZE + length);
+
+    records.push({ timestamp, direction, source: `${ip}:${port}`, payload });
+    offset += RECORD_HEADER_SIZE + length;
+  }
+
+  return records;
+}
+
+function percentile(sorted, value) {
+  if (sorted.length === 0)
+    return 0;
+
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * value))];
+}
+
+async function replay() {
+  const records = readCapture(CAPTURE).filter((record) => record.direction === DIRECTION_RECEIVED);
+
+  if (records.length === 0) {
+    console.log('No received datagrams in capture');
+    return;
+  }
+
+  // One socket per original source so the server sees the same set of peers
+
+  const sockets = new Map();
+  const overflow = new Map();
+  const latencies = [];
+  let received = 0;
+
+  function getSocket(source) {
+    if (!sockets.has(source)) {
+      if (sockets.size >= MAX_SOCKETS) {
+        if (!overflow.has(source))
+          overflow.set(source, [...sockets.values()][overflow.size % MAX_SOCKETS]);
+
+        return overflow.get(source);
+      }
+
+      const socket = dgram.createSocket('udp4');
+      socket.pending = [];
+
+      socket.on('message', () => {
+        received++;
+        const sentAt = socket.pending.shift();
+
+        if (sentAt !== undefined)
+          latencies.push(Number(process.hrtime.bigint() - sentAt) / 1e6);
+      });
+
+      socket.on('error', (err) => console.error(`Replay socket error: ${err.message}`));
+      sockets.set(source, socket);
+    }
+
+    return sockets.get(source);
+  }
+
+  console.log(`Replaying ${records.length} datagrams from ${CAPTURE} to ${HOST}:${PORT} (${FAST ? 'as fast as possible' : `${SPEED}x original timing`})`);
+
+  const firstTimestamp = records[0].timestamp;
+  const start = process.hrtime.bigint();
+  let sent = 0;
+
+  for (const record of records) {
+    if (!FAST) {
+      const due = Number(record.timestamp - firstTimestamp) / 1e6 / SPEED;
+      const elapsed = Number(process.hrtime.bigint() - start) / 1e6;
+
+      if (due > elapsed)
+        await new Promise((resolve) => setTimeout(resolve, due - elapsed));
+    } else if (sent % 256 === 0) {
+      await new Promise((resolve) => setImmediate(resolve));
+    }
+
+    const socket = getSocket(record.source);
+    socket.pending.push(process.hrtime.bigint());
+    socket.send(record.payload, PORT, HOST);
+    sent++;
+  }
+
+  const sendTime = Number(process.hrtime.bigint() - start) / 1e9;
+
+  await new Promise((resolve) => setTimeout(resolve, DRAIN_TIME));
+
+  const totalTime = Number(process.hrtime.bigint() - start) / 1e9 - DRAIN_TIME / 1000;
+  const sorted = latencies.sort((a, b) => a - b);
+
+  console.table([{
+    "Sent": sent,
+    "Received": received,
+    "Peers": sockets.size,
+    "Send Rate (pps)": Math.round(sent / sendTime),
+    "Response Rate (pps)": Math.round(received / totalTime),
+    "Latency p50 (ms)": percentile(sorted, 0.5).toFixed(3),
+    "Latency p99 (ms)": percentile(sorted, 0.99).toFixed(3),
+    "Latency max (ms)": (sorted[sorted.length - 1] || 0).toFixed(3)
+  }]);
+
+  for (const socket of sockets.values())
+    socket.close();
+}
+
+replay();
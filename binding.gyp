@@ -2,7 +2,7 @@
   "targets": [
     {
       "target_name": "nanosockets_binding",
-      "sources": ["src/nanosockets.cpp"],
+      "sources": ["src/nanosockets.cpp", "src/bitbuffer.cpp", "src/capture.cpp", "src/delta.cpp", "src/dispatcher.cpp", "src/filter.cpp", "src/handshake.cpp", "src/secure.cpp", "src/sendqueue.cpp"],
       'include_dirs': [
           "<!@(node -p \"require('node-addon-api').include\")",
           "<(module_root_dir)/src"
@@ -1,5 +1,20 @@
+const net = require('net');
 const nanosockets = require('./build/Release/nanosockets_binding.node');
 
+const RING_HEAD = 0;
+const RING_TAIL = 1;
+const RING_CAPACITY = 2;
+const RING_SLOT_SIZE = 3;
+const RING_DROPPED = 4;
+const RING_HEADER_SIZE = 32;
+const RING_SLOT_HEADER_SIZE = 24;
+
+const COOKIE_CHALLENGE_TAG = Buffer.from('NSCC');
+const COOKIE_ECHO_TAG = Buffer.from('NSCE');
+const COOKIE_CHALLENGE_SIZE = 13;
+
+const FAMILIES = { ipv4: 1, ipv6: 2, all: 3 };
+
 class Address {
   constructor(ip, port) {
     this.ip = ip;
@@ -27,6 +42,118 @@ class Address {
   }
 }
 
+function ipToBytes(ip) {
+  const bytes = new Uint8Array(16);
+
+  if (net.isIPv4(ip)) {
+    bytes[10] = 0xff;
+    bytes[11] = 0xff;
+    ip.split('.').forEach((part, i) => { bytes[12 + i] = Number(part); });
+    return bytes;
+  }
+
+  const [left, right = ''] = ip.split('::');
+  const head = left ? left.split(':') : [];
+  const tail = ip.includes('::') && right ? right.split(':') : [];
+  const groups = [...head, ...new Array(8 - head.length - tail.length).fill('0'), ...tail];
+
+  groups.forEach((group, i) => {
+    const value = parseInt(group, 16);
+    bytes[i * 2] = value >> 8;
+    bytes[i * 2 + 1] = value & 0xff;
+  });
+
+  return bytes;
+}
+
+function bytesToIp(bytes) {
+  if (bytes.subarray(0, 10).every((value) => value === 0) && bytes[10] === 0xff && bytes[11] === 0xff)
+    return Array.from(bytes.subarray(12, 16)).join('.');
+
+  const groups = [];
+
+  for (let i = 0; i < 16; i += 2)
+    groups.push(((bytes[i] << 8) | bytes[i + 1]).toString(16));
+
+  return groups.join(':').replace(/(^|:)0(:0)+(:|$)/, '::');
+}
+
+function toFamily(family) {
+  if (!(family in FAMILIES))
+    throw new TypeError(`Unknown address family: ${family}`);
+
+  return FAMILIES[family];
+}
+
+class DispatcherQueue {
+  constructor(buffer) {
+    this.buffer = buffer;
+    this.header = new Int32Array(buffer, 0, RING_HEADER_SIZE / 4);
+    this.bytes = new Uint8Array(buffer);
+    this.view = new DataView(buffer);
+    this.capacity = this.header[RING_CAPACITY];
+    this.slotSize = this.header[RING_SLOT_SIZE];
+  }
+
+  static allocate(slots, slotSize) {
+    const buffer = new SharedArrayBuffer(RING_HEADER_SIZE + slots * slotSize);
+    const header = new Int32Array(buffer, 0, RING_HEADER_SIZE / 4);
+    header[RING_CAPACITY] = slots;
+    header[RING_SLOT_SIZE] = slotSize;
+    return buffer;
+  }
+
+  get dropped() {
+    return Atomics.load(this.header, RING_DROPPED);
+  }
+
+  push(ip, port, data) {
+    const head = Atomics.load(this.header, RING_HEAD);
+    const tail = Atomics.load(this.header, RING_TAIL);
+
+    if (((head - tail) >>> 0) >= this.capacity || data.length > this.slotSize - RING_SLOT_HEADER_SIZE) {
+      Atomics.add(this.header, RING_DROPPED, 1);
+      return false;
+    }
+
+    const offset = RING_HEADER_SIZE + ((head >>> 0) % this.capacity) * this.slotSize;
+    this.view.setInt32(offset, data.length, true);
+    this.bytes.set(typeof ip === 'string' ? ipToBytes(ip) : ip, offset + 4);
+    this.view.setUint16(offset + 20, port, true);
+    this.bytes.set(data, offset + RING_SLOT_HEADER_SIZE);
+    Atomics.store(this.header, RING_HEAD, head + 1);
+    return true;
+  }
+
+  pop() {
+    const tail = Atomics.load(this.header, RING_TAIL);
+
+    if (tail === Atomics.load(this.header, RING_HEAD))
+      return null;
+
+    const offset = RING_HEADER_SIZE + ((tail >>> 0) % this.capacity) * this.slotSize;
+    const length = this.view.getInt32(offset, true);
+    const ip = this.bytes.slice(offset + 4, offset + 20);
+    const port = this.view.getUint16(offset + 20, true);
+    const data = Buffer.from(this.bytes.subarray(offset + RING_SLOT_HEADER_SIZE, offset + RING_SLOT_HEADER_SIZE + length));
+    Atomics.store(this.header, RING_TAIL, tail + 1);
+    return { ip, address: bytesToIp(ip), port, data };
+  }
+
+  // The native receiver cannot notify JS waiters, so this polls the ring and
+  // sleeps for up to pollInterval milliseconds between empty checks
+
+  receive(timeout, pollInterval = 1) {
+    const deadline = Date.now() + timeout;
+    let packet;
+
+    while ((packet = this.pop()) === null && Date.now() < deadline)
+      Atomics.wait(this.header, RING_HEAD, Atomics.load(this.header, RING_HEAD), pollInterval);
+
+    return packet;
+  }
+}
+
 class UDP {
   static initialize() {
     return nanosockets.initialize();
@@ -68,6 +195,30 @@ class UDP {
     return nanosockets.setDontFragment(socket.handle);
   }
 
+  static setReuseAddress(socket, reuseAddress = true) {
+    return nanosockets.setReuseAddress(socket.handle, reuseAddress);
+  }
+
+  static joinMulticast(socket, group, source = null, interfaceIndex = 0) {
+    return nanosockets.joinMulticast(socket.handle, group, source, interfaceIndex);
+  }
+
+  static leaveMulticast(socket, group, source = null, interfaceIndex = 0) {
+    return nanosockets.leaveMulticast(socket.handle, group, source, interfaceIndex);
+  }
+
+  static setMulticastTTL(socket, ttl, family = 'all') {
+    return nanosockets.setMulticastTTL(socket.handle, ttl, toFamily(family));
+  }
+
+  static setMulticastLoopback(socket, loopback = true, family = 'all') {
+    return nanosockets.setMulticastLoopback(socket.handle, loopback, toFamily(family));
+  }
+
+  static setMulticastInterface(socket, interfaceIndex, family = 'all') {
+    return nanosockets.setMulticastInterface(socket.handle, interfaceIndex, toFamily(family));
+  }
+
   static poll(socket, timeout) {
     return nanosockets.poll(socket.handle, timeout);
   }
@@ -83,6 +234,158 @@ class UDP {
     return { bytesReceived, address, buffer };
   }
 
+  static createConnected(listener, address, sendBufferSize, receiveBufferSize) {
+    return nanosockets.createConnected(listener.handle, address.ip, address.port, sendBufferSize, receiveBufferSize);
+  }
+
+  static sendConnected(socket, buffer) {
+    return nanosockets.sendConnected(socket.handle, buffer);
+  }
+
+  static sendConnectedBatch(socket, buffers) {
+    return nanosockets.sendConnectedBatch(socket.handle, buffers);
+  }
+
+  static receiveConnected(socket, bufferSize) {
+    const bytesReceived = nanosockets.receiveConnected(socket.handle, bufferSize);
+    return { bytesReceived };
+  }
+
+  static attachFilter(socket, options) {
+    return nanosockets.attachFilter(socket.handle, options);
+  }
+
+  static detachFilter(socket) {
+    return nanosockets.detachFilter(socket.handle);
+  }
+
+  static getStats(socket) {
+    return nanosockets.getStats(socket.handle);
+  }
+
+  static enableHandshake(socket, rotationSeconds = 30, maximumPeers = 65536) {
+    return nanosockets.enableHandshake(socket.handle, rotationSeconds, maximumPeers);
+  }
+
+  static disableHandshake(socket) {
+    return nanosockets.disableHandshake(socket.handle);
+  }
+
+  static receiveVerified(socket, bufferSize) {
+    const bytesReceived = nanosockets.receiveVerified(socket.handle, bufferSize);
+    return { bytesReceived };
+  }
+
+  static forgetPeer(socket, address) {
+    return nanosockets.forgetPeer(socket.handle, address.ip, address.port);
+  }
+
+  static getHandshakeStats(socket) {
+    return nanosockets.getHandshakeStats(socket.handle);
+  }
+
+  static isChallenge(buffer) {
+    return buffer.length === COOKIE_CHALLENGE_SIZE && COOKIE_CHALLENGE_TAG.equals(buffer.subarray(0, COOKIE_CHALLENGE_TAG.length));
+  }
+
+  static createCookieEcho(challenge, payload = Buffer.alloc(0)) {
+    const echo = Buffer.concat([challenge, payload]);
+    COOKIE_ECHO_TAG.copy(echo, 0);
+    return echo;
+  }
+
+  static setPeerKey(socket, address, key, isServer = false) {
+    return nanosockets.setPeerKey(socket.handle, address.ip, address.port, key, isServer);
+  }
+
+  static removePeerKey(socket, address) {
+    return nanosockets.removePeerKey(socket.handle, address.ip, address.port);
+  }
+
+  static sendSecure(socket, address, buffer) {
+    return nanosockets.sendSecure(socket.handle, address.ip, address.port, buffer);
+  }
+
+  static sendSecureBatch(socket, address, buffers) {
+    return nanosockets.sendSecureBatch(socket.handle, address.ip, address.port, buffers);
+  }
+
+  static receiveSecure(socket, bufferSize) {
+    const bytesReceived = nanosockets.receiveSecure(socket.handle, bufferSize);
+    return { bytesReceived };
+  }
+
+  static receiveSecureBatch(socket, bufferSize, count = 64) {
+    return nanosockets.receiveSecureBatch(socket.handle, bufferSize, count);
+  }
+
+  static sendBitBuffer(socket, address, bitBuffer) {
+    return nanosockets.sendBitBuffer(socket.handle, address.ip, address.port, bitBuffer);
+  }
+
+  static receiveBitBuffer(socket, bitBuffer) {
+    const bytesReceived = nanosockets.receiveBitBuffer(socket.handle, bitBuffer);
+    return { bytesReceived };
+  }
+
+  static sendSnapshot(socket, address, codec, snapshot) {
+    return nanosockets.sendSnapshot(socket.handle, address.ip, address.port, codec, snapshot);
+  }
+
+  static createSendQueue(socket, options = {}, onWatermark = null) {
+    const capacity = options.capacity ?? 4 * 1024 * 1024;
+    const highWatermark = options.highWatermark ?? Math.floor(capacity * 0.75);
+    const lowWatermark = options.lowWatermark ?? Math.floor(capacity * 0.25);
+    return nanosockets.createSendQueue(socket.handle, capacity, highWatermark, lowWatermark, onWatermark);
+  }
+
+  static destroySendQueue(socket) {
+    return nanosockets.destroySendQueue(socket.handle);
+  }
+
+  static sendQueued(socket, address, buffer) {
+    return nanosockets.sendQueued(socket.handle, address.ip, address.port, buffer);
+  }
+
+  static getSendQueueStats(socket) {
+    return nanosockets.getSendQueueStats(socket.handle);
+  }
+
+  static startCapture(socket, path, format = 'native') {
+    return nanosockets.startCapture(socket.handle, path, format);
+  }
+
+  static stopCapture(socket) {
+    return nanosockets.stopCapture(socket.handle);
+  }
+
+  static createDispatcher(socket, workerCount, slots = 1024, slotSize = 1536) {
+    const receiveQueues = [];
+    const sendQueues = [];
+
+    for (let i = 0; i < workerCount; i++) {
+      receiveQueues.push(DispatcherQueue.allocate(slots, slotSize));
+      sendQueues.push(DispatcherQueue.allocate(slots, slotSize));
+    }
+
+    const dispatcher = nanosockets.createDispatcher(
+      socket.handle,
+      receiveQueues.map((buffer) => new Uint8Array(buffer)),
+      sendQueues.map((buffer) => new Uint8Array(buffer))
+    );
+
+    dispatcher.workers = receiveQueues.map((receiveQueue, i) => ({ receiveQueue, sendQueue: sendQueues[i] }));
+    return dispatcher;
+  }
+
+  static destroyDispatcher(dispatcher) {
+    nanosockets.destroyDispatcher(dispatcher.handle);
+  }
+
+  static getDispatcherStats(dispatcher) {
+    return nanosockets.getDispatcherStats(dispatcher.handle);
+  }
+
   static getAddress(socket) {
     return nanosockets.getAddress(socket);
   }
@@ -95,4 +398,7 @@ class UDP {
 module.exports = {
   UDP,
   Address,
+  DispatcherQueue,
+  BitBuffer: nanosockets.BitBuffer,
+  DeltaCodec: nanosockets.DeltaCodec,
 };
\ No newline at end of file
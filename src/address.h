@@ -0,0 +1,36 @@
+#ifndef NANOSOCKETS_ADDRESS_H
+#define NANOSOCKETS_ADDRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanosockets.h"
+
+// Hashing and equality for NanoAddress keys, shared by the dispatcher's worker
+// selection and the per-peer handshake and session tables.
+
+inline uint32_t nanosockets_address_hash(const NanoAddress* address) {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(address->ipv6); i++) {
+        hash ^= ((const uint8_t*)&address->ipv6)[i];
+        hash *= 16777619u;
+    }
+
+    hash ^= address->port & 0xFF;
+    hash *= 16777619u;
+    hash ^= address->port >> 8;
+    hash *= 16777619u;
+
+    return hash;
+}
+
+struct AddressHash {
+    size_t operator()(const NanoAddress& address) const { return nanosockets_address_hash(&address); }
+};
+
+struct AddressEqual {
+    bool operator()(const NanoAddress& left, const NanoAddress& right) const { return nanosockets_address_is_equal(&left, &right) == NANOSOCKETS_STATUS_OK; }
+};
+
+#endif // NANOSOCKETS_ADDRESS_H
@@ -0,0 +1,267 @@
+#include <math.h>
+#include <string.h>
+
+#include "bitbuffer.h"
+
+#define NANOSOCKETS_BITBUFFER_MAX_STRING 4096
+
+BitBuffer::BitBuffer(size_t capacity) : data(capacity), dirtyLength(0), writePosition(0), readPosition(0), error(false) {
+}
+
+void BitBuffer::Reset() {
+    writePosition = 0;
+    readPosition = 0;
+    error = false;
+
+    // Strings learned while writing or reading a packet only live for that packet
+
+    for (const std::string& value : packetStrings)
+        stringIndices.erase(value);
+
+    packetStrings.clear();
+}
+
+void BitBuffer::Clear() {
+    // Add ORs bits into zeroed storage, so every byte a longer packet ever left
+    // behind has to be cleared, not just the current length
+
+    memset(data.data(), 0, dirtyLength > Length() ? dirtyLength : Length());
+
+    dirtyLength = 0;
+
+    Reset();
+}
+
+bool BitBuffer::SetLength(size_t length) {
+    if (length > data.size())
+        return false;
+
+    // The bytes were just written into Data(), so they must not be zeroed
+
+    size_t written = Length() > length ? Length() : length;
+
+    if (written > dirtyLength)
+        dirtyLength = written;
+
+    Reset();
+
+    writePosition = length << 3;
+
+    return true;
+}
+
+bool BitBuffer::Add(uint32_t value, int bits) {
+    if (bits <= 0 || bits > 32 || writePosition + bits > data.size() << 3) {
+        error = true;
+
+        return false;
+    }
+
+    if (bits < 32)
+        value &= (1u << bits) - 1;
+
+    while (bits > 0) {
+        size_t offset = writePosition & 7;
+        int count = 8 - (int)offset < bits ? 8 - (int)offset : bits;
+
+        data[writePosition >> 3] |= (uint8_t)((value & ((1u << count) - 1)) << offset);
+
+        value >>= count;
+        bits -= count;
+        writePosition += count;
+    }
+
+    return true;
+}
+
+uint32_t BitBuffer::Peek(int bits) const {
+    if (bits <= 0 || bits > 32 || readPosition + bits > writePosition)
+        return 0;
+
+    uint32_t value = 0;
+    size_t position = readPosition;
+    int shift = 0;
+
+    while (shift < bits) {
+        size_t offset = position & 7;
+        int count = 8 - (int)offset < bits - shift ? 8 - (int)offset : bits - shift;
+
+        value |= (uint32_t)((data[position >> 3] >> offset) & ((1u << count) - 1)) << shift;
+
+        shift += count;
+        position += count;
+    }
+
+    return value;
+}
+
+uint32_t BitBuffer::Read(int bits) {
+    if (bits <= 0 || bits > 32 || readPosition + bits > writePosition) {
+        error = true;
+
+        return 0;
+    }
+
+    uint32_t value = Peek(bits);
+
+    readPosition += bits;
+
+    return value;
+}
+
+bool BitBuffer::AddUInt(uint32_t value) {
+    do {
+        uint32_t group = value & 0x7F;
+
+        value >>= 7;
+
+        if (!Add(value != 0 ? group | 0x80 : group, 8))
+            return false;
+    } while (value != 0);
+
+    return true;
+}
+
+uint32_t BitBuffer::ReadUInt() {
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint32_t group = Read(8);
+
+        value |= (group & 0x7F) << shift;
+
+        if ((group & 0x80) == 0 || error)
+            return value;
+    }
+
+    error = true;
+
+    return 0;
+}
+
+bool BitBuffer::AddInt(int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+    return AddUInt(zigzag);
+}
+
+int32_t BitBuffer::ReadInt() {
+    uint32_t zigzag = ReadUInt();
+
+    return (int32_t)((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
+
+bool BitBuffer::AddFloat(float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return Add(bits, 32);
+}
+
+float BitBuffer::ReadFloat() {
+    uint32_t bits = Read(32);
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+bool BitBuffer::AddQuantized(float value, float minimum, float maximum, int bits) {
+    if (bits <= 0 || bits > 32 || maximum <= minimum) {
+        error = true;
+
+        return false;
+    }
+
+    double steps = (double)(bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1);
+    double clamped = value < minimum ? minimum : (value > maximum ? maximum : value);
+
+    return Add((uint32_t)llround((clamped - minimum) / ((double)maximum - minimum) * steps), bits);
+}
+
+float BitBuffer::ReadQuantized(float minimum, float maximum, int bits) {
+    if (bits <= 0 || bits > 32 || maximum <= minimum) {
+        error = true;
+
+        return 0.0f;
+    }
+
+    double steps = (double)(bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1);
+
+    return (float)(minimum + Read(bits) / steps * ((double)maximum - minimum));
+}
+
+void BitBuffer::SetStringTable(const std::vector<std::string>& strings) {
+    Clear();
+
+    presetStrings = strings;
+    stringIndices.clear();
+
+    for (size_t i = 0; i < presetStrings.size(); i++)
+        stringIndices.emplace(presetStrings[i], (uint32_t)i);
+}
+
+void BitBuffer::Remember(const std::string& value) {
+    if (stringIndices.emplace(value, (uint32_t)(presetStrings.size() + packetStrings.size())).second)
+        packetStrings.push_back(value);
+}
+
+// Strings are written as a 1-bit flag followed by either a table index or a
+// length-prefixed literal, which is then added to the packet's table
+
+bool BitBuffer::AddString(const std::string& value) {
+    auto index = stringIndices.find(value);
+
+    if (index != stringIndices.end())
+        return Add(1, 1) && AddUInt(index->second);
+
+    if (value.size() > NANOSOCKETS_BITBUFFER_MAX_STRING || !Add(0, 1) || !AddUInt((uint32_t)value.size())) {
+        error = true;
+
+        return false;
+    }
+
+    for (unsigned char character : value) {
+        if (!Add(character, 8))
+            return false;
+    }
+
+    Remember(value);
+
+    return true;
+}
+
+std::string BitBuffer::ReadString() {
+    if (Read(1) == 1) {
+        uint32_t index = ReadUInt();
+
+        if (index < presetStrings.size())
+            return presetStrings[index];
+
+        if (index - presetStrings.size() < packetStrings.size())
+            return packetStrings[index - presetStrings.size()];
+
+        error = true;
+
+        return std::string();
+    }
+
+    uint32_t length = ReadUInt();
+
+    if (error || length > NANOSOCKETS_BITBUFFER_MAX_STRING || readPosition + (size_t)length * 8 > writePosition) {
+        error = true;
+
+        return std::string();
+    }
+
+    std::string value(length, '\0');
+
+    for (uint32_t i = 0; i < length; i++)
+        value[i] = (char)Read(8);
+
+    Remember(value);
+
+    return value;
+}
@@ -0,0 +1,72 @@
+#ifndef NANOSOCKETS_BITBUFFER_H
+#define NANOSOCKETS_BITBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bit-packing serializer whose storage is the datagram itself, so a packet can
+// be written and sent, or received and read, without an intermediate buffer.
+// Bits are packed LSB-first within each byte.
+
+#define NANOSOCKETS_BITBUFFER_DEFAULT_CAPACITY 1500
+
+class BitBuffer {
+public:
+    explicit BitBuffer(size_t capacity = NANOSOCKETS_BITBUFFER_DEFAULT_CAPACITY);
+
+    void Clear();
+
+    bool Add(uint32_t value, int bits);
+    uint32_t Read(int bits);
+    uint32_t Peek(int bits) const;
+
+    bool AddUInt(uint32_t value);
+    uint32_t ReadUInt();
+
+    bool AddInt(int32_t value);
+    int32_t ReadInt();
+
+    bool AddFloat(float value);
+    float ReadFloat();
+
+    bool AddQuantized(float value, float minimum, float maximum, int bits);
+    float ReadQuantized(float minimum, float maximum, int bits);
+
+    bool AddString(const std::string& value);
+    std::string ReadString();
+
+    // Strings known to both ends up front, encoded as their index
+    void SetStringTable(const std::vector<std::string>& strings);
+
+    uint8_t* Data() { return data.data(); }
+    size_t Capacity() const { return data.size(); }
+    size_t Length() const { return (writePosition + 7) >> 3; }
+
+    // Marks length bytes of Data() as a received packet ready for reading. Call
+    // Clear() before writing into a buffer that was used for reading.
+    bool SetLength(size_t length);
+
+    // After SetLength the end is only known to the byte, so the zero padding of
+    // the last byte must be read as well before this reports true
+    bool IsFinished() const { return readPosition >= writePosition; }
+    bool HasError() const { return error; }
+
+private:
+    void Reset();
+    void Remember(const std::string& value);
+
+    std::vector<uint8_t> data;
+    size_t dirtyLength;
+    size_t writePosition;
+    size_t readPosition;
+    bool error;
+
+    std::vector<std::string> presetStrings;
+    std::vector<std::string> packetStrings;
+    std::unordered_map<std::string, uint32_t> stringIndices;
+};
+
+#endif // NANOSOCKETS_BITBUFFER_H
@@ -0,0 +1,281 @@
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include "capture.h"
+
+#define NANOSOCKETS_CAPTURE_CHUNK_SIZE (16 * 1024 * 1024)
+#define NANOSOCKETS_PCAP_MAGIC 0xA1B23C4D
+#define NANOSOCKETS_PCAP_LINKTYPE_RAW 101
+#define NANOSOCKETS_PCAP_SNAPLEN 65535
+
+static std::mutex captureMutex;
+static std::map<NanoSocket, std::unique_ptr<Capture>> captures;
+static std::atomic<int> activeCaptures(0);
+
+static uint64_t nanosockets_capture_timestamp(void) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+Capture::Capture(NanoSocket socket, CaptureFormat format) : socket(socket), format(format), records(0) {
+    memset(&localAddress, 0, sizeof(localAddress));
+    memset(&peerAddress, 0, sizeof(peerAddress));
+    nanosockets_address_get(socket, &localAddress);
+
+    // Connected sockets send and receive without an address, so their records
+    // use the peer the socket is connected to
+
+    peerResolved = nanosockets_address_get_peer(socket, &peerAddress) == NANOSOCKETS_STATUS_OK;
+
+    #ifdef _WIN32
+        file = NULL;
+    #else
+        descriptor = -1;
+        mapping = NULL;
+        mappingSize = 0;
+        position = 0;
+    #endif
+}
+
+Capture::~Capture() {
+    Close();
+}
+
+bool Capture::Open(const std::string& path) {
+    #ifdef _WIN32
+        file = fopen(path.c_str(), "wb");
+
+        if (file == NULL)
+            return false;
+    #else
+        descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (descriptor < 0)
+            return false;
+    #endif
+
+    if (!Reserve(NANOSOCKETS_CAPTURE_CHUNK_SIZE))
+        return false;
+
+    if (format == CAPTURE_PCAP) {
+        uint32_t header[6] = { NANOSOCKETS_PCAP_MAGIC, 2 | (4u << 16), 0, 0, NANOSOCKETS_PCAP_SNAPLEN, NANOSOCKETS_PCAP_LINKTYPE_RAW };
+
+        Append(header, sizeof(header));
+    } else {
+        Append(NANOSOCKETS_CAPTURE_MAGIC, NANOSOCKETS_CAPTURE_MAGIC_SIZE);
+    }
+
+    return true;
+}
+
+void Capture::Close() {
+    #ifdef _WIN32
+        if (file != NULL) {
+            fclose(file);
+            file = NULL;
+        }
+    #else
+        if (mapping != NULL) {
+            munmap(mapping, mappingSize);
+            mapping = NULL;
+        }
+
+        if (descriptor >= 0) {
+            // Trim the preallocated tail so the file ends at the last record
+
+            if (ftruncate(descriptor, position) != 0)
+                position = 0;
+
+            close(descriptor);
+            descriptor = -1;
+        }
+    #endif
+}
+
+bool Capture::Reserve(size_t length) {
+    #ifdef _WIN32
+        return file != NULL;
+    #else
+        if (descriptor < 0)
+            return false;
+
+        if (position + length <= mappingSize)
+            return true;
+
+        size_t size = mappingSize + NANOSOCKETS_CAPTURE_CHUNK_SIZE;
+
+        while (position + length > size)
+            size += NANOSOCKETS_CAPTURE_CHUNK_SIZE;
+
+        if (mapping != NULL)
+            munmap(mapping, mappingSize);
+
+        mapping = NULL;
+        mappingSize = 0;
+
+        if (ftruncate(descriptor, size) != 0)
+            return false;
+
+        void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+        if (region == MAP_FAILED)
+            return false;
+
+        mapping = (uint8_t*)region;
+        mappingSize = size;
+
+        return true;
+    #endif
+}
+
+void Capture::Append(const void* data, size_t length) {
+    #ifdef _WIN32
+        fwrite(data, 1, length, file);
+    #else
+        memcpy(mapping + position, data, length);
+        position += length;
+    #endif
+}
+
+void Capture::Record(CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length) {
+    uint64_t timestamp = nanosockets_capture_timestamp();
+
+    if (address == NULL) {
+        if (!peerResolved)
+            peerResolved = nanosockets_address_get_peer(socket, &peerAddress) == NANOSOCKETS_STATUS_OK;
+
+        address = &peerAddress;
+    }
+
+    if (format == CAPTURE_PCAP) {
+        RecordPcap(timestamp, direction, address, buffer, length);
+        return;
+    }
+
+    if (!Reserve(NANOSOCKETS_CAPTURE_RECORD_HEADER_SIZE + length))
+        return;
+
+    uint8_t header[NANOSOCKETS_CAPTURE_RECORD_HEADER_SIZE] = { 0 };
+    uint32_t recordLength = length;
+
+    memcpy(header, &timestamp, sizeof(timestamp));
+    header[8] = (uint8_t)direction;
+
+    memcpy(header + 10, &address->port, sizeof(address->port));
+    memcpy(header + 12, &address->ipv6, sizeof(address->ipv6));
+
+    memcpy(header + 28, &recordLength, sizeof(recordLength));
+
+    Append(header, sizeof(header));
+    Append(buffer, length);
+
+    records++;
+}
+
+void Capture::RecordPcap(uint64_t timestamp, CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length) {
+    NanoAddress remote = *address;
+
+    const NanoAddress* source = direction == CAPTURE_RECEIVED ? &remote : &localAddress;
+    const NanoAddress* destination = direction == CAPTURE_RECEIVED ? &localAddress : &remote;
+    bool ipv4 = remote.ipv4.ffff == 0xFFFF && remote.ipv4.zeros[0] == 0 && memcmp(remote.ipv4.zeros, remote.ipv4.zeros + 1, sizeof(remote.ipv4.zeros) - 1) == 0;
+    uint8_t packet[48] = { 0 };
+    size_t ipHeaderSize = ipv4 ? 20 : 40;
+    uint32_t udpLength = 8 + length;
+    uint32_t totalLength = (uint32_t)ipHeaderSize + udpLength;
+
+    if (ipv4) {
+        packet[0] = 0x45;
+        packet[2] = (uint8_t)(totalLength >> 8);
+        packet[3] = (uint8_t)totalLength;
+        packet[8] = 64;
+        packet[9] = 17;
+        memcpy(packet + 12, &source->ipv4.ip, 4);
+        memcpy(packet + 16, &destination->ipv4.ip, 4);
+
+        uint32_t checksum = 0;
+
+        for (int i = 0; i < 20; i += 2)
+            checksum += (packet[i] << 8) | packet[i + 1];
+
+        while (checksum >> 16)
+            checksum = (checksum & 0xFFFF) + (checksum >> 16);
+
+        checksum = ~checksum & 0xFFFF;
+        packet[10] = (uint8_t)(checksum >> 8);
+        packet[11] = (uint8_t)checksum;
+    } else {
+        packet[0] = 0x60;
+        packet[4] = (uint8_t)(udpLength >> 8);
+        packet[5] = (uint8_t)udpLength;
+        packet[6] = 17;
+        packet[7] = 64;
+        memcpy(packet + 8, &source->ipv6, 16);
+        memcpy(packet + 24, &destination->ipv6, 16);
+    }
+
+    uint8_t* udp = packet + ipHeaderSize;
+
+    udp[0] = (uint8_t)(source->port >> 8);
+    udp[1] = (uint8_t)source->port;
+    udp[2] = (uint8_t)(destination->port >> 8);
+    udp[3] = (uint8_t)destination->port;
+    udp[4] = (uint8_t)(udpLength >> 8);
+    udp[5] = (uint8_t)udpLength;
+
+    uint32_t capturedLength = totalLength > NANOSOCKETS_PCAP_SNAPLEN ? NANOSOCKETS_PCAP_SNAPLEN : totalLength;
+    uint32_t recordHeader[4] = { (uint32_t)(timestamp / 1000000000ULL), (uint32_t)(timestamp % 1000000000ULL), capturedLength, totalLength };
+
+    if (!Reserve(sizeof(recordHeader) + capturedLength))
+        return;
+
+    Append(recordHeader, sizeof(recordHeader));
+    Append(packet, ipHeaderSize + 8);
+    Append(buffer, capturedLength - ipHeaderSize - 8);
+
+    records++;
+}
+
+bool nanosockets_capture_start(NanoSocket socket, const char* path, CaptureFormat format) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    std::unique_ptr<Capture> capture(new Capture(socket, format));
+
+    if (!capture->Open(path))
+        return false;
+
+    if (captures.find(socket) == captures.end())
+        activeCaptures.fetch_add(1, std::memory_order_relaxed);
+
+    captures[socket] = std::move(capture);
+
+    return true;
+}
+
+void nanosockets_capture_stop(NanoSocket socket) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+
+    if (captures.erase(socket) > 0)
+        activeCaptures.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool nanosockets_capture_active(void) {
+    return activeCaptures.load(std::memory_order_relaxed) > 0;
+}
+
+void nanosockets_capture_record_slow(NanoSocket socket, CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    auto capture = captures.find(socket);
+
+    if (capture != captures.end())
+        capture->second->Record(direction, address, buffer, length);
+}
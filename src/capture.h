@@ -0,0 +1,82 @@
+#ifndef NANOSOCKETS_CAPTURE_H
+#define NANOSOCKETS_CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#include "nanosockets.h"
+
+// Opt-in traffic capture. The native format is a memory-mapped append-only
+// file made of an 8-byte magic followed by records of
+//   [timestamp:8][direction:1][reserved:1][port:2][ip:16][length:4][payload]
+// in little-endian order, with timestamps in nanoseconds since the Unix epoch.
+// A zero timestamp marks the end of the records. The pcap format wraps each
+// datagram in synthesized IPv4/IPv6 and UDP headers.
+
+#define NANOSOCKETS_CAPTURE_MAGIC "NSCAP001"
+#define NANOSOCKETS_CAPTURE_MAGIC_SIZE 8
+#define NANOSOCKETS_CAPTURE_RECORD_HEADER_SIZE 32
+
+enum CaptureDirection {
+    CAPTURE_RECEIVED = 0,
+    CAPTURE_SENT = 1
+};
+
+enum CaptureFormat {
+    CAPTURE_NATIVE = 0,
+    CAPTURE_PCAP = 1
+};
+
+class Capture {
+public:
+    Capture(NanoSocket socket, CaptureFormat format);
+    ~Capture();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    void Record(CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length);
+
+    uint64_t Records() const { return records; }
+
+private:
+    bool Reserve(size_t length);
+    void Append(const void* data, size_t length);
+    void RecordPcap(uint64_t timestamp, CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length);
+
+    NanoSocket socket;
+    CaptureFormat format;
+    NanoAddress localAddress;
+    NanoAddress peerAddress;
+    bool peerResolved;
+    uint64_t records;
+
+    #ifdef _WIN32
+        FILE* file;
+    #else
+        int descriptor;
+        uint8_t* mapping;
+        size_t mappingSize;
+        size_t position;
+    #endif
+};
+
+// Global capture registry, safe to call from any thread. Recording is a single
+// relaxed load when no socket is being captured.
+
+bool nanosockets_capture_start(NanoSocket socket, const char* path, CaptureFormat format);
+
+void nanosockets_capture_stop(NanoSocket socket);
+
+void nanosockets_capture_record_slow(NanoSocket socket, CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length);
+
+bool nanosockets_capture_active(void);
+
+inline void nanosockets_capture_record(NanoSocket socket, CaptureDirection direction, const NanoAddress* address, const uint8_t* buffer, int length) {
+    if (length >= 0 && nanosockets_capture_active())
+        nanosockets_capture_record_slow(socket, direction, address, buffer, length);
+}
+
+#endif // NANOSOCKETS_CAPTURE_H
@@ -0,0 +1,224 @@
+#include <string.h>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define NANOSOCKETS_DELTA_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define NANOSOCKETS_DELTA_NEON 1
+#endif
+
+#include "delta.h"
+
+// A changed run is only closed once this many equal bytes follow it, so short
+// matches inside noisy regions do not cost a run header each
+#define NANOSOCKETS_DELTA_MIN_MATCH 4
+
+static size_t nanosockets_delta_equal_length(const uint8_t* left, const uint8_t* right, size_t length) {
+    size_t position = 0;
+
+    #if defined(NANOSOCKETS_DELTA_SSE2)
+        while (position + 16 <= length) {
+            __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(left + position)), _mm_loadu_si128((const __m128i*)(right + position)));
+            unsigned mask = (unsigned)_mm_movemask_epi8(equal);
+
+            if (mask != 0xFFFF)
+                return position + __builtin_ctz(~mask);
+
+            position += 16;
+        }
+    #elif defined(NANOSOCKETS_DELTA_NEON)
+        while (position + 16 <= length) {
+            uint8x16_t equal = vceqq_u8(vld1q_u8(left + position), vld1q_u8(right + position));
+
+            if (vminvq_u8(equal) != 0xFF)
+                break;
+
+            position += 16;
+        }
+    #endif
+
+    while (position < length && left[position] == right[position])
+        position++;
+
+    return position;
+}
+
+static size_t nanosockets_delta_write_varint(uint8_t* output, uint32_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        output[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    output[length++] = (uint8_t)value;
+
+    return length;
+}
+
+static bool nanosockets_delta_read_varint(const uint8_t* input, size_t length, size_t* position, uint32_t* value) {
+    *value = 0;
+
+    for (int shift = 0; shift < 35 && *position < length; shift += 7) {
+        uint8_t group = input[(*position)++];
+
+        *value |= (uint32_t)(group & 0x7F) << shift;
+
+        if ((group & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+DeltaCodec::DeltaCodec() : nextSequence(0), acknowledged(0), hasAcknowledged(false) {
+    for (int i = 0; i < NANOSOCKETS_DELTA_BASELINES; i++) {
+        sent[i].valid = false;
+        received[i].valid = false;
+    }
+}
+
+size_t DeltaCodec::MaximumEncodedSize(size_t length) {
+    // Header, length varint, and one run header per byte in the worst case of
+    // alternating changes is bounded by 3 bytes of varints per 5 input bytes
+
+    return NANOSOCKETS_DELTA_HEADER_SIZE + 5 + length + (length / (NANOSOCKETS_DELTA_MIN_MATCH + 1) + 1) * 6;
+}
+
+Snapshot* DeltaCodec::Find(Snapshot* ring, uint16_t sequence) {
+    Snapshot* snapshot = &ring[sequence % NANOSOCKETS_DELTA_BASELINES];
+
+    return snapshot->valid && snapshot->sequence == sequence ? snapshot : NULL;
+}
+
+void DeltaCodec::Acknowledge(uint16_t sequence) {
+    // Ignore acknowledgements older than the current baseline
+
+    if (Find(sent, sequence) == NULL || (hasAcknowledged && (int16_t)(sequence - acknowledged) <= 0))
+        return;
+
+    acknowledged = sequence;
+    hasAcknowledged = true;
+}
+
+int DeltaCodec::Encode(const uint8_t* snapshot, size_t length, uint8_t* output) {
+    if (length > NANOSOCKETS_DELTA_MAX_SNAPSHOT)
+        return -1;
+
+    uint16_t sequence = nextSequence++;
+    Snapshot* baseline = hasAcknowledged ? Find(sent, acknowledged) : NULL;
+    size_t position = NANOSOCKETS_DELTA_HEADER_SIZE;
+
+    output[1] = (uint8_t)sequence;
+    output[2] = (uint8_t)(sequence >> 8);
+    output[3] = baseline != NULL ? (uint8_t)baseline->sequence : 0;
+    output[4] = baseline != NULL ? (uint8_t)(baseline->sequence >> 8) : 0;
+
+    position += nanosockets_delta_write_varint(output + position, (uint32_t)length);
+
+    if (baseline == NULL) {
+        output[0] = DELTA_FULL;
+        memcpy(output + position, snapshot, length);
+        position += length;
+    } else {
+        const uint8_t* previous = baseline->data.data();
+        size_t common = baseline->data.size() < length ? baseline->data.size() : length;
+        size_t offset = 0;
+
+        output[0] = DELTA_XOR;
+
+        while (offset < length) {
+            size_t unchanged = offset < common ? nanosockets_delta_equal_length(snapshot + offset, previous + offset, common - offset) : 0;
+            size_t start = offset + unchanged;
+            size_t end = start;
+
+            if (start == length)
+                break;
+
+            // Extend the changed run until a long enough match or the end
+
+            while (end < length) {
+                if (end < common && end + NANOSOCKETS_DELTA_MIN_MATCH <= common && nanosockets_delta_equal_length(snapshot + end, previous + end, NANOSOCKETS_DELTA_MIN_MATCH) == NANOSOCKETS_DELTA_MIN_MATCH)
+                    break;
+
+                end++;
+            }
+
+            position += nanosockets_delta_write_varint(output + position, (uint32_t)unchanged);
+            position += nanosockets_delta_write_varint(output + position, (uint32_t)(end - start));
+
+            for (size_t i = start; i < end; i++)
+                output[position++] = snapshot[i] ^ (i < common ? previous[i] : 0);
+
+            offset = end;
+        }
+    }
+
+    Snapshot* slot = &sent[sequence % NANOSOCKETS_DELTA_BASELINES];
+
+    slot->sequence = sequence;
+    slot->valid = true;
+    slot->data.assign(snapshot, snapshot + length);
+
+    return (int)position;
+}
+
+const Snapshot* DeltaCodec::Decode(const uint8_t* packet, size_t length) {
+    if (length < NANOSOCKETS_DELTA_HEADER_SIZE)
+        return NULL;
+
+    uint8_t type = packet[0];
+    uint16_t sequence = packet[1] | (packet[2] << 8);
+    uint16_t baselineSequence = packet[3] | (packet[4] << 8);
+    size_t position = NANOSOCKETS_DELTA_HEADER_SIZE;
+    uint32_t snapshotLength;
+
+    if (!nanosockets_delta_read_varint(packet, length, &position, &snapshotLength) || snapshotLength > NANOSOCKETS_DELTA_MAX_SNAPSHOT)
+        return NULL;
+
+    std::vector<uint8_t> data;
+
+    if (type == DELTA_FULL) {
+        if (length - position != snapshotLength)
+            return NULL;
+
+        data.assign(packet + position, packet + length);
+    } else if (type == DELTA_XOR) {
+        Snapshot* baseline = Find(received, baselineSequence);
+
+        if (baseline == NULL)
+            return NULL;
+
+        size_t common = baseline->data.size() < snapshotLength ? baseline->data.size() : snapshotLength;
+        size_t offset = 0;
+
+        data.assign(snapshotLength, 0);
+        memcpy(data.data(), baseline->data.data(), common);
+
+        while (position < length) {
+            uint32_t unchanged, changed;
+
+            if (!nanosockets_delta_read_varint(packet, length, &position, &unchanged) || !nanosockets_delta_read_varint(packet, length, &position, &changed))
+                return NULL;
+
+            offset += unchanged;
+
+            if (offset + changed > snapshotLength || position + changed > length)
+                return NULL;
+
+            for (uint32_t i = 0; i < changed; i++, offset++)
+                data[offset] ^= packet[position++];
+        }
+    } else {
+        return NULL;
+    }
+
+    Snapshot* slot = &received[sequence % NANOSOCKETS_DELTA_BASELINES];
+
+    slot->sequence = sequence;
+    slot->valid = true;
+    slot->data.swap(data);
+
+    return slot;
+}
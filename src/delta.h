@@ -0,0 +1,56 @@
+#ifndef NANOSOCKETS_DELTA_H
+#define NANOSOCKETS_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Per-peer snapshot delta codec. Outgoing snapshots are kept in a small ring
+// and encoded against the newest one the peer acknowledged; incoming ones are
+// kept so later deltas can be reconstructed. Packet layout:
+//   [type:1][sequence:2][baseline:2][length:varint][body]
+// where a full body is the snapshot itself and a delta body is a list of
+// (unchanged:varint, changed:varint, changed bytes XOR baseline) runs.
+
+#define NANOSOCKETS_DELTA_BASELINES 32
+#define NANOSOCKETS_DELTA_HEADER_SIZE 5
+#define NANOSOCKETS_DELTA_MAX_SNAPSHOT 65536
+
+enum DeltaType {
+    DELTA_FULL = 0,
+    DELTA_XOR = 1
+};
+
+struct Snapshot {
+    uint16_t sequence;
+    bool valid;
+    std::vector<uint8_t> data;
+};
+
+class DeltaCodec {
+public:
+    DeltaCodec();
+
+    // Worst-case encoded size, for sizing the output buffer
+    static size_t MaximumEncodedSize(size_t length);
+
+    // Returns the encoded length written to output, or -1 if the snapshot is too large
+    int Encode(const uint8_t* snapshot, size_t length, uint8_t* output);
+
+    void Acknowledge(uint16_t sequence);
+
+    // Returns the reconstructed snapshot, or NULL if the packet is malformed or
+    // refers to a baseline that is no longer known
+    const Snapshot* Decode(const uint8_t* packet, size_t length);
+
+private:
+    Snapshot* Find(Snapshot* ring, uint16_t sequence);
+
+    Snapshot sent[NANOSOCKETS_DELTA_BASELINES];
+    Snapshot received[NANOSOCKETS_DELTA_BASELINES];
+    uint16_t nextSequence;
+    uint16_t acknowledged;
+    bool hasAcknowledged;
+};
+
+#endif // NANOSOCKETS_DELTA_H
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+#include "address.h"
+#include "capture.h"
+#include "dispatcher.h"
+
+#define NANOSOCKETS_DISPATCHER_POLL_TIMEOUT 100
+#define NANOSOCKETS_DISPATCHER_IDLE_MICROSECONDS 50
+#define NANOSOCKETS_DISPATCHER_IDLE_MAXIMUM_MICROSECONDS 2000
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "Ring header requires lock-free int32 atomics");
+
+bool Ring::Attach(uint8_t* data, size_t length) {
+    if (data == NULL || length < NANOSOCKETS_RING_HEADER_SIZE || ((uintptr_t)data & 3) != 0)
+        return false;
+
+    int32_t headerCapacity = ((const int32_t*)data)[NANOSOCKETS_RING_CAPACITY];
+    int32_t headerSlotSize = ((const int32_t*)data)[NANOSOCKETS_RING_SLOT_SIZE];
+
+    if (headerCapacity <= 0 || headerSlotSize < NANOSOCKETS_RING_SLOT_HEADER_SIZE)
+        return false;
+
+    if ((uint64_t)headerCapacity * (uint64_t)headerSlotSize > length - NANOSOCKETS_RING_HEADER_SIZE)
+        return false;
+
+    this->data = data;
+    this->length = length;
+    this->capacity = (uint32_t)headerCapacity;
+    this->slotSize = (uint32_t)headerSlotSize;
+
+    return true;
+}
+
+int32_t Ring::Load(int index) const {
+    return ((std::atomic<int32_t>*)&Header()[index])->load(std::memory_order_acquire);
+}
+
+void Ring::Store(int index, int32_t value) {
+    ((std::atomic<int32_t>*)&Header()[index])->store(value, std::memory_order_release);
+}
+
+uint8_t* Ring::Slot(uint32_t index) const {
+    return data + NANOSOCKETS_RING_HEADER_SIZE + (size_t)(index % capacity) * slotSize;
+}
+
+int32_t Ring::PayloadSize() const {
+    return slotSize - NANOSOCKETS_RING_SLOT_HEADER_SIZE;
+}
+
+bool Ring::Push(const NanoAddress* address, const uint8_t* payload, int length) {
+    uint32_t head = Load(NANOSOCKETS_RING_HEAD);
+    uint32_t tail = Load(NANOSOCKETS_RING_TAIL);
+
+    if (head - tail >= capacity || length > PayloadSize()) {
+        ((std::atomic<int32_t>*)&Header()[NANOSOCKETS_RING_DROPPED])->fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    uint8_t* slot = Slot(head);
+    int32_t slotLength = length;
+    uint16_t port = address->port;
+
+    memcpy(slot, &slotLength, sizeof(slotLength));
+    memcpy(slot + 4, &address->ipv6, sizeof(address->ipv6));
+    memcpy(slot + 20, &port, sizeof(port));
+    memcpy(slot + NANOSOCKETS_RING_SLOT_HEADER_SIZE, payload, length);
+
+    Store(NANOSOCKETS_RING_HEAD, head + 1);
+
+    return true;
+}
+
+int Ring::Pop(NanoAddress* address, uint8_t* payload, int length) {
+    uint32_t tail = Load(NANOSOCKETS_RING_TAIL);
+    uint32_t head = Load(NANOSOCKETS_RING_HEAD);
+
+    if (tail == head)
+        return -1;
+
+    uint8_t* slot = Slot(tail);
+    int32_t slotLength = 0;
+
+    memcpy(&slotLength, slot, sizeof(slotLength));
+    memcpy(&address->ipv6, slot + 4, sizeof(address->ipv6));
+    memcpy(&address->port, slot + 20, sizeof(address->port));
+
+    if (slotLength < 0 || slotLength > length || slotLength > PayloadSize())
+        slotLength = 0;
+
+    memcpy(payload, slot + NANOSOCKETS_RING_SLOT_HEADER_SIZE, slotLength);
+
+    Store(NANOSOCKETS_RING_TAIL, tail + 1);
+
+    return slotLength;
+}
+
+Dispatcher::Dispatcher(NanoSocket socket, std::vector<Ring> receiveRings, std::vector<Ring> sendRings)
+    : socket(socket), receiveRings(std::move(receiveRings)), sendRings(std::move(sendRings)),
+      running(false), received(0), sent(0), dropped(0) {
+}
+
+Dispatcher::~Dispatcher() {
+    Stop();
+}
+
+void Dispatcher::Start() {
+    if (running.exchange(true))
+        return;
+
+    receiver = std::thread(&Dispatcher::ReceiveLoop, this);
+    sender = std::thread(&Dispatcher::SendLoop, this);
+}
+
+void Dispatcher::Stop() {
+    if (!running.exchange(false))
+        return;
+
+    if (receiver.joinable())
+        receiver.join();
+
+    if (sender.joinable())
+        sender.join();
+}
+
+void Dispatcher::ReceiveLoop() {
+    std::vector<uint8_t> buffer(65536);
+    NanoAddress address = { 0 };
+
+    while (running.load(std::memory_order_relaxed)) {
+        if (nanosockets_poll(socket, NANOSOCKETS_DISPATCHER_POLL_TIMEOUT) <= 0)
+            continue;
+
+        int length = nanosockets_receive(socket, &address, buffer.data(), (int)buffer.size());
+
+        if (length < 0)
+            continue;
+
+        nanosockets_capture_record(socket, CAPTURE_RECEIVED, &address, buffer.data(), length);
+
+        Ring& ring = receiveRings[nanosockets_address_hash(&address) % receiveRings.size()];
+
+        if (ring.Push(&address, buffer.data(), length))
+            received.fetch_add(1, std::memory_order_relaxed);
+        else
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// JS producers do not wake the sender, so an idle sender sleeps with an
+// exponential backoff that resets as soon as any ring yields a datagram
+
+void Dispatcher::SendLoop() {
+    std::vector<uint8_t> buffer(65536);
+    NanoAddress address = { 0 };
+    int idleMicroseconds = NANOSOCKETS_DISPATCHER_IDLE_MICROSECONDS;
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool idle = true;
+
+        for (Ring& ring : sendRings) {
+            int length;
+
+            while ((length = ring.Pop(&address, buffer.data(), (int)buffer.size())) >= 0) {
+                if (nanosockets_send(socket, &address, buffer.data(), length) >= 0) {
+                    nanosockets_capture_record(socket, CAPTURE_SENT, &address, buffer.data(), length);
+                    sent.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                idle = false;
+            }
+        }
+
+        if (!idle) {
+            idleMicroseconds = NANOSOCKETS_DISPATCHER_IDLE_MICROSECONDS;
+
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(idleMicroseconds));
+
+        if (idleMicroseconds < NANOSOCKETS_DISPATCHER_IDLE_MAXIMUM_MICROSECONDS)
+            idleMicroseconds = std::min(idleMicroseconds * 2, NANOSOCKETS_DISPATCHER_IDLE_MAXIMUM_MICROSECONDS);
+    }
+}
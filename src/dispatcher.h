@@ -0,0 +1,72 @@
+#ifndef NANOSOCKETS_DISPATCHER_H
+#define NANOSOCKETS_DISPATCHER_H
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "nanosockets.h"
+
+// Ring layout shared with JS through a SharedArrayBuffer. The header is a block
+// of int32 fields so both sides can use Atomics on the same words.
+
+#define NANOSOCKETS_RING_HEAD 0
+#define NANOSOCKETS_RING_TAIL 1
+#define NANOSOCKETS_RING_CAPACITY 2
+#define NANOSOCKETS_RING_SLOT_SIZE 3
+#define NANOSOCKETS_RING_DROPPED 4
+#define NANOSOCKETS_RING_HEADER_SIZE 32
+#define NANOSOCKETS_RING_SLOT_HEADER_SIZE 24
+
+// Capacity and slot size are read from the shared header once by Attach and
+// cached, so JS rewriting the header later cannot move slots out of bounds
+
+struct Ring {
+    uint8_t* data;
+    size_t length;
+    uint32_t capacity;
+    uint32_t slotSize;
+
+    bool Attach(uint8_t* data, size_t length);
+
+    int32_t* Header() const { return (int32_t*)data; }
+    int32_t Load(int index) const;
+    void Store(int index, int32_t value);
+    uint8_t* Slot(uint32_t index) const;
+    int32_t PayloadSize() const;
+
+    bool Push(const NanoAddress* address, const uint8_t* payload, int length);
+    int Pop(NanoAddress* address, uint8_t* payload, int length);
+};
+
+class Dispatcher {
+public:
+    Dispatcher(NanoSocket socket, std::vector<Ring> receiveRings, std::vector<Ring> sendRings);
+    ~Dispatcher();
+
+    void Start();
+    void Stop();
+
+    NanoSocket Socket() const { return socket; }
+
+    uint64_t Received() const { return received.load(std::memory_order_relaxed); }
+    uint64_t Sent() const { return sent.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void ReceiveLoop();
+    void SendLoop();
+
+    NanoSocket socket;
+    std::vector<Ring> receiveRings;
+    std::vector<Ring> sendRings;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> received;
+    std::atomic<uint64_t> sent;
+    std::atomic<uint64_t> dropped;
+    std::thread receiver;
+    std::thread sender;
+};
+
+#endif // NANOSOCKETS_DISPATCHER_H
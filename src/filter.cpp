@@ -0,0 +1,139 @@
+#include <string.h>
+
+#ifdef __linux__
+    #include <linux/filter.h>
+    #include <linux/sock_diag.h>
+    #include <sys/socket.h>
+#endif
+
+#include "filter.h"
+
+// Opcodes from linux/filter.h, kept here so the builder compiles everywhere
+
+#define NANOSOCKETS_BPF_LD_W_ABS 0x20
+#define NANOSOCKETS_BPF_LD_H_ABS 0x28
+#define NANOSOCKETS_BPF_LD_B_ABS 0x30
+#define NANOSOCKETS_BPF_LD_W_LEN 0x80
+#define NANOSOCKETS_BPF_JEQ_K 0x15
+#define NANOSOCKETS_BPF_JGT_K 0x25
+#define NANOSOCKETS_BPF_JGE_K 0x35
+#define NANOSOCKETS_BPF_RET_K 0x06
+
+#define NANOSOCKETS_UDP_HEADER_SIZE 8
+#define NANOSOCKETS_FILTER_ACCEPT 0xFFFFFFFF
+
+void Filter::Reject() {
+    instructions.push_back({ NANOSOCKETS_BPF_RET_K, 0, 0, 0 });
+}
+
+void Filter::MinimumLength(uint32_t length) {
+    instructions.push_back({ NANOSOCKETS_BPF_LD_W_LEN, 0, 0, 0 });
+    instructions.push_back({ NANOSOCKETS_BPF_JGE_K, 1, 0, length + NANOSOCKETS_UDP_HEADER_SIZE });
+    Reject();
+}
+
+void Filter::MaximumLength(uint32_t length) {
+    instructions.push_back({ NANOSOCKETS_BPF_LD_W_LEN, 0, 0, 0 });
+    instructions.push_back({ NANOSOCKETS_BPF_JGT_K, 0, 1, length + NANOSOCKETS_UDP_HEADER_SIZE });
+    Reject();
+}
+
+void Filter::Prefix(uint32_t offset, const uint8_t* bytes, size_t length) {
+    size_t position = 0;
+
+    while (position < length) {
+        size_t remaining = length - position;
+        uint32_t absolute = NANOSOCKETS_UDP_HEADER_SIZE + offset + (uint32_t)position;
+        uint16_t code;
+        uint32_t value;
+        size_t size;
+
+        // Absolute loads are in network byte order
+
+        if (remaining >= 4) {
+            code = NANOSOCKETS_BPF_LD_W_ABS;
+            value = ((uint32_t)bytes[position] << 24) | ((uint32_t)bytes[position + 1] << 16) | ((uint32_t)bytes[position + 2] << 8) | bytes[position + 3];
+            size = 4;
+        } else if (remaining >= 2) {
+            code = NANOSOCKETS_BPF_LD_H_ABS;
+            value = ((uint32_t)bytes[position] << 8) | bytes[position + 1];
+            size = 2;
+        } else {
+            code = NANOSOCKETS_BPF_LD_B_ABS;
+            value = bytes[position];
+            size = 1;
+        }
+
+        instructions.push_back({ code, 0, 0, absolute });
+        instructions.push_back({ NANOSOCKETS_BPF_JEQ_K, 1, 0, value });
+        Reject();
+
+        position += size;
+    }
+}
+
+void Filter::ByteRange(uint32_t offset, uint8_t minimum, uint8_t maximum) {
+    instructions.push_back({ NANOSOCKETS_BPF_LD_B_ABS, 0, 0, NANOSOCKETS_UDP_HEADER_SIZE + offset });
+    instructions.push_back({ NANOSOCKETS_BPF_JGE_K, 1, 0, minimum });
+    Reject();
+    instructions.push_back({ NANOSOCKETS_BPF_JGT_K, 0, 1, maximum });
+    Reject();
+}
+
+const std::vector<FilterInstruction>& Filter::Build() {
+    program = instructions;
+    program.push_back({ NANOSOCKETS_BPF_RET_K, 0, 0, NANOSOCKETS_FILTER_ACCEPT });
+
+    return program;
+}
+
+int Filter::Attach(NanoSocket socket) {
+    #ifdef __linux__
+        static_assert(sizeof(FilterInstruction) == sizeof(struct sock_filter), "Filter instruction layout mismatch");
+
+        const std::vector<FilterInstruction>& code = Build();
+        struct sock_fprog filterProgram = { 0 };
+
+        filterProgram.len = (unsigned short)code.size();
+        filterProgram.filter = (struct sock_filter*)code.data();
+
+        return setsockopt(socket, SOL_SOCKET, SO_ATTACH_FILTER, &filterProgram, sizeof(filterProgram));
+    #else
+        return -1;
+    #endif
+}
+
+int Filter::Detach(NanoSocket socket) {
+    #ifdef __linux__
+        int value = 0;
+
+        return setsockopt(socket, SOL_SOCKET, SO_DETACH_FILTER, &value, sizeof(value));
+    #else
+        return -1;
+    #endif
+}
+
+int nanosockets_get_stats(NanoSocket socket, SocketStats* stats) {
+    memset(stats, 0, sizeof(SocketStats));
+
+    #if defined(__linux__) && defined(SO_MEMINFO)
+        uint32_t memoryInfo[SK_MEMINFO_VARS] = { 0 };
+        socklen_t memoryInfoLength = sizeof(memoryInfo);
+
+        if (getsockopt(socket, SOL_SOCKET, SO_MEMINFO, memoryInfo, &memoryInfoLength) != 0)
+            return -1;
+
+        // Packets rejected by an attached filter are accounted as socket drops,
+        // together with datagrams dropped because the receive buffer was full
+
+        stats->receiveQueued = memoryInfo[SK_MEMINFO_RMEM_ALLOC];
+        stats->receiveBuffer = memoryInfo[SK_MEMINFO_RCVBUF];
+        stats->sendQueued = memoryInfo[SK_MEMINFO_WMEM_ALLOC];
+        stats->sendBuffer = memoryInfo[SK_MEMINFO_SNDBUF];
+        stats->drops = memoryInfo[SK_MEMINFO_DROPS];
+
+        return 0;
+    #else
+        return -1;
+    #endif
+}
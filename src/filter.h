@@ -0,0 +1,50 @@
+#ifndef NANOSOCKETS_FILTER_H
+#define NANOSOCKETS_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "nanosockets.h"
+
+// Classic BPF program builder for datagram sockets. Rules are checked in the
+// order they were added and a packet is accepted only if all of them pass.
+// Offsets and lengths refer to the UDP payload, not the UDP header.
+
+struct FilterInstruction {
+    uint16_t code;
+    uint8_t jt;
+    uint8_t jf;
+    uint32_t k;
+};
+
+class Filter {
+public:
+    void MinimumLength(uint32_t length);
+    void MaximumLength(uint32_t length);
+    void Prefix(uint32_t offset, const uint8_t* bytes, size_t length);
+    void ByteRange(uint32_t offset, uint8_t minimum, uint8_t maximum);
+
+    const std::vector<FilterInstruction>& Build();
+
+    int Attach(NanoSocket socket);
+    static int Detach(NanoSocket socket);
+
+private:
+    void Reject();
+
+    std::vector<FilterInstruction> instructions;
+    std::vector<FilterInstruction> program;
+};
+
+struct SocketStats {
+    uint32_t receiveQueued;
+    uint32_t receiveBuffer;
+    uint32_t sendQueued;
+    uint32_t sendBuffer;
+    uint32_t drops;
+};
+
+int nanosockets_get_stats(NanoSocket socket, SocketStats* stats);
+
+#endif // NANOSOCKETS_FILTER_H
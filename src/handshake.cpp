@@ -0,0 +1,183 @@
+#include <chrono>
+#include <random>
+
+#include "handshake.h"
+
+static const uint8_t challengeTag[NANOSOCKETS_COOKIE_TAG_SIZE] = { 'N', 'S', 'C', 'C' };
+static const uint8_t echoTag[NANOSOCKETS_COOKIE_TAG_SIZE] = { 'N', 'S', 'C', 'E' };
+
+#define NANOSOCKETS_ROTL(value, bits) (((value) << (bits)) | ((value) >> (64 - (bits))))
+
+#define NANOSOCKETS_SIPROUND \
+    do { \
+        v0 += v1; v1 = NANOSOCKETS_ROTL(v1, 13); v1 ^= v0; v0 = NANOSOCKETS_ROTL(v0, 32); \
+        v2 += v3; v3 = NANOSOCKETS_ROTL(v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = NANOSOCKETS_ROTL(v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = NANOSOCKETS_ROTL(v1, 17); v1 ^= v2; v2 = NANOSOCKETS_ROTL(v2, 32); \
+    } while (0)
+
+uint64_t nanosockets_siphash(const uint64_t key[2], const uint8_t* data, size_t length) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+    size_t blocks = length / 8;
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t block = 0;
+
+        for (int j = 0; j < 8; j++)
+            block |= (uint64_t)data[i * 8 + j] << (8 * j);
+
+        v3 ^= block;
+        NANOSOCKETS_SIPROUND;
+        NANOSOCKETS_SIPROUND;
+        v0 ^= block;
+    }
+
+    uint64_t last = (uint64_t)length << 56;
+
+    for (size_t j = 0; j < length % 8; j++)
+        last |= (uint64_t)data[blocks * 8 + j] << (8 * j);
+
+    v3 ^= last;
+    NANOSOCKETS_SIPROUND;
+    NANOSOCKETS_SIPROUND;
+    v0 ^= last;
+
+    v2 ^= 0xFF;
+    NANOSOCKETS_SIPROUND;
+    NANOSOCKETS_SIPROUND;
+    NANOSOCKETS_SIPROUND;
+    NANOSOCKETS_SIPROUND;
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+static uint32_t nanosockets_epoch(uint32_t rotationSeconds) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::seconds>(now).count() / rotationSeconds);
+}
+
+Handshake::Handshake(uint32_t rotationSeconds, size_t maximumPeers)
+    : rotationSeconds(rotationSeconds > 0 ? rotationSeconds : 1), maximumPeers(maximumPeers),
+      challengesSent(0), cookiesRejected(0) {
+    std::random_device random;
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++)
+            secrets[i][j] = ((uint64_t)random() << 32) | random();
+    }
+
+    epoch = nanosockets_epoch(this->rotationSeconds);
+}
+
+void Handshake::Rotate() {
+    uint32_t current = nanosockets_epoch(rotationSeconds);
+
+    if (current == epoch)
+        return;
+
+    // Replace the secret of every epoch that is no longer current or previous
+
+    std::random_device random;
+    uint32_t stale = current - epoch > 1 ? 2 : 1;
+
+    for (uint32_t i = 0; i < stale; i++) {
+        uint64_t* secret = secrets[(current - i) & 1];
+
+        secret[0] = ((uint64_t)random() << 32) | random();
+        secret[1] = ((uint64_t)random() << 32) | random();
+    }
+
+    epoch = current;
+}
+
+uint64_t Handshake::Cookie(const NanoAddress* address, uint32_t cookieEpoch) const {
+    uint8_t input[sizeof(address->ipv6) + sizeof(address->port) + sizeof(cookieEpoch)];
+
+    memcpy(input, &address->ipv6, sizeof(address->ipv6));
+    memcpy(input + sizeof(address->ipv6), &address->port, sizeof(address->port));
+    memcpy(input + sizeof(address->ipv6) + sizeof(address->port), &cookieEpoch, sizeof(cookieEpoch));
+
+    return nanosockets_siphash(secrets[cookieEpoch & 1], input, sizeof(input));
+}
+
+bool Handshake::IsVerified(const NanoAddress* address) const {
+    return peers.find(*address) != peers.end();
+}
+
+void Handshake::Forget(const NanoAddress* address) {
+    peers.erase(*address);
+}
+
+// A cookie echo is recognised for verified peers too, so a retransmitted echo
+// is stripped instead of reaching the application as data
+
+bool Handshake::IsEcho(const NanoAddress* address, const uint8_t* buffer, int length) {
+    if (length < NANOSOCKETS_CHALLENGE_SIZE || memcmp(buffer, echoTag, NANOSOCKETS_COOKIE_TAG_SIZE) != 0)
+        return false;
+
+    Rotate();
+
+    uint8_t parity = buffer[NANOSOCKETS_COOKIE_TAG_SIZE];
+
+    if (parity > 1)
+        return false;
+
+    uint32_t cookieEpoch = (epoch & 1) == parity ? epoch : epoch - 1;
+    uint64_t expected = Cookie(address, cookieEpoch);
+    uint64_t received = 0;
+
+    memcpy(&received, buffer + NANOSOCKETS_COOKIE_TAG_SIZE + 1, sizeof(received));
+
+    return (expected ^ received) == 0;
+}
+
+HandshakeResult Handshake::Process(NanoSocket socket, const NanoAddress* address, const uint8_t* buffer, int length, int* payloadOffset) {
+    *payloadOffset = 0;
+
+    if (IsVerified(address)) {
+        if (!IsEcho(address, buffer, length))
+            return HANDSHAKE_DELIVER;
+
+        *payloadOffset = NANOSOCKETS_CHALLENGE_SIZE;
+
+        return length > NANOSOCKETS_CHALLENGE_SIZE ? HANDSHAKE_DELIVER : HANDSHAKE_CONSUMED;
+    }
+
+    if (length >= NANOSOCKETS_CHALLENGE_SIZE && memcmp(buffer, echoTag, NANOSOCKETS_COOKIE_TAG_SIZE) == 0) {
+        if (!IsEcho(address, buffer, length) || peers.size() >= maximumPeers) {
+            cookiesRejected++;
+
+            return HANDSHAKE_DROPPED;
+        }
+
+        peers.insert(*address);
+
+        *payloadOffset = NANOSOCKETS_CHALLENGE_SIZE;
+
+        return length > NANOSOCKETS_CHALLENGE_SIZE ? HANDSHAKE_DELIVER : HANDSHAKE_CONSUMED;
+    }
+
+    // A challenge is never larger than the datagram that triggered it, so
+    // spoofed sources cannot use the server to amplify traffic
+
+    if (length < NANOSOCKETS_CHALLENGE_SIZE)
+        return HANDSHAKE_DROPPED;
+
+    Rotate();
+
+    uint8_t challenge[NANOSOCKETS_CHALLENGE_SIZE];
+    uint64_t cookie = Cookie(address, epoch);
+
+    memcpy(challenge, challengeTag, NANOSOCKETS_COOKIE_TAG_SIZE);
+    challenge[NANOSOCKETS_COOKIE_TAG_SIZE] = epoch & 1;
+    memcpy(challenge + NANOSOCKETS_COOKIE_TAG_SIZE + 1, &cookie, sizeof(cookie));
+
+    nanosockets_send(socket, address, challenge, sizeof(challenge));
+    challengesSent++;
+
+    return HANDSHAKE_CONSUMED;
+}
@@ -0,0 +1,56 @@
+#ifndef NANOSOCKETS_HANDSHAKE_H
+#define NANOSOCKETS_HANDSHAKE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <unordered_set>
+
+#include "address.h"
+#include "nanosockets.h"
+
+// Stateless return-routability check. Unknown sources receive a challenge
+// carrying a keyed cookie of their address, and are only entered into the
+// peer table once they echo it back. No state is kept for unverified sources.
+
+#define NANOSOCKETS_COOKIE_SIZE 8
+#define NANOSOCKETS_COOKIE_TAG_SIZE 4
+#define NANOSOCKETS_CHALLENGE_SIZE (NANOSOCKETS_COOKIE_TAG_SIZE + 1 + NANOSOCKETS_COOKIE_SIZE)
+
+enum HandshakeResult {
+    HANDSHAKE_DELIVER = 0,
+    HANDSHAKE_CONSUMED = 1,
+    HANDSHAKE_DROPPED = 2
+};
+
+class Handshake {
+public:
+    Handshake(uint32_t rotationSeconds, size_t maximumPeers);
+
+    // Classifies a received datagram. On HANDSHAKE_DELIVER, payloadOffset is
+    // set to where application data starts (past the echoed cookie, if any).
+    HandshakeResult Process(NanoSocket socket, const NanoAddress* address, const uint8_t* buffer, int length, int* payloadOffset);
+
+    bool IsVerified(const NanoAddress* address) const;
+    void Forget(const NanoAddress* address);
+
+    size_t Peers() const { return peers.size(); }
+    uint64_t ChallengesSent() const { return challengesSent; }
+    uint64_t CookiesRejected() const { return cookiesRejected; }
+
+private:
+    void Rotate();
+    bool IsEcho(const NanoAddress* address, const uint8_t* buffer, int length);
+    uint64_t Cookie(const NanoAddress* address, uint32_t epoch) const;
+
+    uint32_t rotationSeconds;
+    size_t maximumPeers;
+    uint32_t epoch;
+    uint64_t secrets[2][2];
+    std::unordered_set<NanoAddress, AddressHash, AddressEqual> peers;
+    uint64_t challengesSent;
+    uint64_t cookiesRejected;
+};
+
+uint64_t nanosockets_siphash(const uint64_t key[2], const uint8_t* data, size_t length);
+
+#endif // NANOSOCKETS_HANDSHAKE_H
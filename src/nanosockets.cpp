@@ -2,6 +2,11 @@
 #include <iostream>
 #include <mutex>
 #include <alloca.h>
+#include <uv.h>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #if defined(_WIN32) || defined(_WIN64)
     #include <windows.h>
@@ -11,6 +16,15 @@
 
 #define NANOSOCKETS_IMPLEMENTATION
 #include "nanosockets.h" 
+#include "address.h"
+#include "bitbuffer.h"
+#include "capture.h"
+#include "delta.h"
+#include "dispatcher.h"
+#include "filter.h"
+#include "handshake.h"
+#include "secure.h"
+#include "sendqueue.h"
 
 std::mutex socketMutex;
 
@@ -18,6 +32,54 @@ struct Socket {
     int64_t handle;
 };
 
+struct DispatcherEntry {
+    std::unique_ptr<Dispatcher> dispatcher;
+    std::vector<Napi::Reference<Napi::Uint8Array>> views;
+};
+
+std::map<int32_t, DispatcherEntry> dispatchers;
+int32_t dispatcherCounter = 0;
+
+std::map<NanoSocket, std::unique_ptr<Handshake>> handshakes;
+
+typedef std::unordered_map<NanoAddress, std::unique_ptr<SecureSession>, AddressHash, AddressEqual> SecureSessions;
+
+std::map<NanoSocket, SecureSessions> secureSessions;
+
+struct SendQueueEntry {
+    std::unique_ptr<SendQueue> queue;
+    uv_poll_t* poll;
+    uv_timer_t* timer;
+    bool polling;
+    bool timing;
+    napi_env env;
+    Napi::FunctionReference callback;
+};
+
+std::map<NanoSocket, std::unique_ptr<SendQueueEntry>> sendQueues;
+
+void CloseSendQueue(NanoSocket socket) {
+    auto entry = sendQueues.find(socket);
+
+    if (entry == sendQueues.end())
+        return;
+
+    uv_close((uv_handle_t*)entry->second->poll, [](uv_handle_t* handle) { delete (uv_poll_t*)handle; });
+    uv_close((uv_handle_t*)entry->second->timer, [](uv_handle_t* handle) { delete (uv_timer_t*)handle; });
+    sendQueues.erase(entry);
+}
+
+SecureSession* FindSecureSession(NanoSocket socket, const NanoAddress* address) {
+    auto sessions = secureSessions.find(socket);
+
+    if (sessions == secureSessions.end())
+        return NULL;
+
+    auto session = sessions->second.find(*address);
+
+    return session != sessions->second.end() ? session->second.get() : NULL;
+}
+
 Napi::Value Initialize(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     NanoStatus status = nanosockets_initialize();
@@ -50,6 +112,19 @@ Napi::Value Destroy(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
     
+    for (auto entry = dispatchers.begin(); entry != dispatchers.end();) {
+        if (entry->second.dispatcher->Socket() == socket) {
+            entry->second.dispatcher->Stop();
+            entry = dispatchers.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+
+    handshakes.erase(socket);
+    secureSessions.erase(socket);
+    CloseSendQueue(socket);
+    nanosockets_capture_stop(socket);
     nanosockets_destroy(&socket);
     return env.Undefined();
 }
@@ -132,6 +207,86 @@ Napi::Value SetDontFragment(const Napi::CallbackInfo& info) {
     return Napi::Number::New(env, status);
 }
 
+Napi::Value SetReuseAddress(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    bool reuseAddress = info[1].As<Napi::Boolean>().Value();
+
+    NanoStatus status = nanosockets_set_reuseaddress(socket, reuseAddress ? 1 : 0);
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value Multicast(const Napi::CallbackInfo& info, bool join) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string groupIp = info[1].As<Napi::String>();
+    uint32_t interfaceIndex = info[3].As<Napi::Number>().Uint32Value();
+
+    NanoAddress group = { 0 };
+    NanoAddress source = { 0 };
+
+    if (nanosockets_address_set_ip(&group, groupIp.c_str()) != NANOSOCKETS_STATUS_OK) {
+        Napi::TypeError::New(env, "Invalid multicast group").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool hasSource = info[2].IsString();
+
+    if (hasSource && nanosockets_address_set_ip(&source, info[2].As<Napi::String>().Utf8Value().c_str()) != NANOSOCKETS_STATUS_OK) {
+        Napi::TypeError::New(env, "Invalid multicast source").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    NanoStatus status = join ?
+        nanosockets_multicast_join(socket, &group, hasSource ? &source : NULL, interfaceIndex) :
+        nanosockets_multicast_leave(socket, &group, hasSource ? &source : NULL, interfaceIndex);
+
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value JoinMulticast(const Napi::CallbackInfo& info) {
+    return Multicast(info, true);
+}
+
+Napi::Value LeaveMulticast(const Napi::CallbackInfo& info) {
+    return Multicast(info, false);
+}
+
+Napi::Value SetMulticastTTL(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    int ttl = info[1].As<Napi::Number>().Int32Value();
+    NanoFamily family = (NanoFamily)info[2].As<Napi::Number>().Int32Value();
+
+    NanoStatus status = nanosockets_multicast_set_ttl(socket, ttl, family);
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value SetMulticastLoopback(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    bool loopback = info[1].As<Napi::Boolean>().Value();
+    NanoFamily family = (NanoFamily)info[2].As<Napi::Number>().Int32Value();
+
+    NanoStatus status = nanosockets_multicast_set_loopback(socket, loopback ? 1 : 0, family);
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value SetMulticastInterface(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    uint32_t interfaceIndex = info[1].As<Napi::Number>().Uint32Value();
+    NanoFamily family = (NanoFamily)info[2].As<Napi::Number>().Int32Value();
+
+    NanoStatus status = nanosockets_multicast_set_interface(socket, interfaceIndex, family);
+    return Napi::Number::New(env, status);
+}
+
 Napi::Value Poll(const Napi::CallbackInfo& info) {
     std::lock_guard<std::mutex> lock(socketMutex);
     Napi::Env env = info.Env();
@@ -155,6 +310,10 @@ Napi::Value Send(const Napi::CallbackInfo& info) {
     address.port = port;
 
     int sendResult = nanosockets_send(socket, &address, buffer.Data(), buffer.Length());
+
+    if (sendResult >= 0)
+        nanosockets_capture_record(socket, CAPTURE_SENT, &address, buffer.Data(), buffer.Length());
+
     return Napi::Number::New(env, sendResult);
 }
 
@@ -168,6 +327,7 @@ Napi::Value Receive(const Napi::CallbackInfo& info) {
     NanoAddress address;
     
     int receiveResult = nanosockets_receive(socket, &address, buffer, bufferSize);
+    nanosockets_capture_record(socket, CAPTURE_RECEIVED, &address, buffer, receiveResult);
     
     Napi::Object result = Napi::Object::New(env);
     result.Set("status", Napi::Number::New(env, receiveResult));
@@ -182,6 +342,1097 @@ Napi::Value Receive(const Napi::CallbackInfo& info) {
     return result;
 }
 
+Napi::Value CreateConnected(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket listener = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    int sendBufferSize = info[3].As<Napi::Number>().Int32Value();
+    int receiveBufferSize = info[4].As<Napi::Number>().Int32Value();
+
+    NanoAddress address;
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    int64_t socketHandle = nanosockets_create_connected(listener, &address, sendBufferSize, receiveBufferSize);
+
+    Napi::Object socketObj = Napi::Object::New(env);
+    socketObj.Set("handle", Napi::Number::New(env, socketHandle));
+    socketObj.Set("IsCreated", Napi::Boolean::New(env, socketHandle > 0));
+
+    return socketObj;
+}
+
+Napi::Value SendConnected(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    Napi::Buffer<uint8_t> buffer = info[1].As<Napi::Buffer<uint8_t>>();
+
+    int sendResult = nanosockets_send_connected(socket, buffer.Data(), buffer.Length());
+
+    if (sendResult >= 0)
+        nanosockets_capture_record(socket, CAPTURE_SENT, NULL, buffer.Data(), buffer.Length());
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value SendConnectedBatch(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    Napi::Array buffers = info[1].As<Napi::Array>();
+    uint32_t count = buffers.Length();
+
+    std::vector<const uint8_t*> data(count);
+    std::vector<int> lengths(count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        Napi::Buffer<uint8_t> buffer = buffers.Get(i).As<Napi::Buffer<uint8_t>>();
+        data[i] = buffer.Data();
+        lengths[i] = buffer.Length();
+    }
+
+    int sendResult = nanosockets_send_connected_batch(socket, data.data(), lengths.data(), count);
+
+    for (int i = 0; i < sendResult; i++)
+        nanosockets_capture_record(socket, CAPTURE_SENT, NULL, data[i], lengths[i]);
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value ReceiveConnected(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    int bufferSize = info[1].As<Napi::Number>().Int32Value();
+
+    uint8_t* buffer = (uint8_t*)alloca(bufferSize);
+
+    int receiveResult = nanosockets_receive_connected(socket, buffer, bufferSize);
+    nanosockets_capture_record(socket, CAPTURE_RECEIVED, NULL, buffer, receiveResult);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("status", Napi::Number::New(env, receiveResult));
+    result.Set("data", Napi::Buffer<uint8_t>::Copy(env, buffer, receiveResult > 0 ? receiveResult : 0));
+
+    return result;
+}
+
+bool GetRings(Napi::Env env, Napi::Array array, std::vector<Ring>& rings, DispatcherEntry& entry) {
+    for (uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Uint8Array view = array.Get(i).As<Napi::Uint8Array>();
+        Ring ring = {};
+
+        if (!ring.Attach(view.Data(), view.ByteLength())) {
+            Napi::RangeError::New(env, "Queue header does not match its buffer").ThrowAsJavaScriptException();
+            return false;
+        }
+
+        rings.push_back(ring);
+        entry.views.push_back(Napi::Persistent(view));
+    }
+
+    return true;
+}
+
+Napi::Value CreateDispatcher(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    Napi::Array receiveViews = info[1].As<Napi::Array>();
+    Napi::Array sendViews = info[2].As<Napi::Array>();
+
+    if (receiveViews.Length() == 0) {
+        Napi::TypeError::New(env, "Expected at least one receive queue").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DispatcherEntry entry;
+    std::vector<Ring> receiveRings;
+    std::vector<Ring> sendRings;
+
+    if (!GetRings(env, receiveViews, receiveRings, entry) || !GetRings(env, sendViews, sendRings, entry))
+        return env.Null();
+
+    int32_t handle = ++dispatcherCounter;
+
+    entry.dispatcher.reset(new Dispatcher(socket, std::move(receiveRings), std::move(sendRings)));
+    entry.dispatcher->Start();
+    dispatchers[handle] = std::move(entry);
+
+    Napi::Object dispatcherObj = Napi::Object::New(env);
+    dispatcherObj.Set("handle", Napi::Number::New(env, handle));
+
+    return dispatcherObj;
+}
+
+Napi::Value DestroyDispatcher(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    int32_t handle = info[0].As<Napi::Number>().Int32Value();
+
+    auto entry = dispatchers.find(handle);
+
+    if (entry != dispatchers.end()) {
+        entry->second.dispatcher->Stop();
+        dispatchers.erase(entry);
+    }
+
+    return env.Undefined();
+}
+
+Napi::Value GetDispatcherStats(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    int32_t handle = info[0].As<Napi::Number>().Int32Value();
+
+    auto entry = dispatchers.find(handle);
+
+    if (entry == dispatchers.end()) {
+        Napi::TypeError::New(env, "Unknown dispatcher").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Dispatcher* dispatcher = entry->second.dispatcher.get();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("received", Napi::Number::New(env, (double)dispatcher->Received()));
+    result.Set("sent", Napi::Number::New(env, (double)dispatcher->Sent()));
+    result.Set("dropped", Napi::Number::New(env, (double)dispatcher->Dropped()));
+
+    return result;
+}
+
+Napi::Value AttachFilter(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    Napi::Object options = info[1].As<Napi::Object>();
+
+    Filter filter;
+
+    if (options.Has("minimumLength"))
+        filter.MinimumLength(options.Get("minimumLength").As<Napi::Number>().Uint32Value());
+
+    if (options.Has("maximumLength"))
+        filter.MaximumLength(options.Get("maximumLength").As<Napi::Number>().Uint32Value());
+
+    if (options.Has("prefix")) {
+        Napi::Buffer<uint8_t> prefix = options.Get("prefix").As<Napi::Buffer<uint8_t>>();
+        uint32_t prefixOffset = options.Has("prefixOffset") ? options.Get("prefixOffset").As<Napi::Number>().Uint32Value() : 0;
+
+        filter.Prefix(prefixOffset, prefix.Data(), prefix.Length());
+    }
+
+    if (options.Has("ranges")) {
+        Napi::Array ranges = options.Get("ranges").As<Napi::Array>();
+
+        for (uint32_t i = 0; i < ranges.Length(); i++) {
+            Napi::Object range = ranges.Get(i).As<Napi::Object>();
+
+            filter.ByteRange(
+                range.Get("offset").As<Napi::Number>().Uint32Value(),
+                range.Get("minimum").As<Napi::Number>().Uint32Value(),
+                range.Get("maximum").As<Napi::Number>().Uint32Value()
+            );
+        }
+    }
+
+    int status = filter.Attach(socket);
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value DetachFilter(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    int status = Filter::Detach(socket);
+    return Napi::Number::New(env, status);
+}
+
+Napi::Value GetStats(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    SocketStats stats;
+    int status = nanosockets_get_stats(socket, &stats);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("status", Napi::Number::New(env, status));
+    result.Set("receiveQueued", Napi::Number::New(env, stats.receiveQueued));
+    result.Set("receiveBuffer", Napi::Number::New(env, stats.receiveBuffer));
+    result.Set("sendQueued", Napi::Number::New(env, stats.sendQueued));
+    result.Set("sendBuffer", Napi::Number::New(env, stats.sendBuffer));
+    result.Set("drops", Napi::Number::New(env, stats.drops));
+
+    return result;
+}
+
+Napi::Value EnableHandshake(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    uint32_t rotationSeconds = info[1].As<Napi::Number>().Uint32Value();
+    uint32_t maximumPeers = info[2].As<Napi::Number>().Uint32Value();
+
+    handshakes[socket].reset(new Handshake(rotationSeconds, maximumPeers));
+
+    return env.Undefined();
+}
+
+Napi::Value DisableHandshake(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    handshakes.erase(socket);
+
+    return env.Undefined();
+}
+
+Napi::Value ReceiveVerified(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    int bufferSize = info[1].As<Napi::Number>().Int32Value();
+
+    auto handshake = handshakes.find(socket);
+
+    if (handshake == handshakes.end()) {
+        Napi::TypeError::New(env, "Handshake is not enabled for this socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint8_t* buffer = (uint8_t*)alloca(bufferSize);
+    NanoAddress address;
+    int receiveResult;
+    int payloadOffset = 0;
+
+    // Handshake traffic is answered here and never reaches JS
+
+    while ((receiveResult = nanosockets_receive(socket, &address, buffer, bufferSize)) >= 0) {
+        nanosockets_capture_record(socket, CAPTURE_RECEIVED, &address, buffer, receiveResult);
+
+        if (handshake->second->Process(socket, &address, buffer, receiveResult, &payloadOffset) == HANDSHAKE_DELIVER)
+            break;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+
+    if (receiveResult < 0) {
+        result.Set("status", Napi::Number::New(env, receiveResult));
+        result.Set("data", Napi::Buffer<uint8_t>::New(env, 0));
+        return result;
+    }
+
+    result.Set("status", Napi::Number::New(env, receiveResult - payloadOffset));
+    result.Set("data", Napi::Buffer<uint8_t>::Copy(env, buffer + payloadOffset, receiveResult - payloadOffset));
+
+    char ip[INET6_ADDRSTRLEN];
+    nanosockets_address_get_ip(&address, ip, sizeof(ip));
+
+    result.Set("address", Napi::String::New(env, ip));
+    result.Set("port", Napi::Number::New(env, address.port));
+
+    return result;
+}
+
+Napi::Value ForgetPeer(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+
+    auto handshake = handshakes.find(socket);
+
+    if (handshake != handshakes.end()) {
+        NanoAddress address = { 0 };
+        nanosockets_address_set_ip(&address, ip.c_str());
+        address.port = port;
+
+        handshake->second->Forget(&address);
+    }
+
+    return env.Undefined();
+}
+
+Napi::Value GetHandshakeStats(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    auto handshake = handshakes.find(socket);
+
+    if (handshake == handshakes.end()) {
+        Napi::TypeError::New(env, "Handshake is not enabled for this socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("peers", Napi::Number::New(env, (double)handshake->second->Peers()));
+    result.Set("challengesSent", Napi::Number::New(env, (double)handshake->second->ChallengesSent()));
+    result.Set("cookiesRejected", Napi::Number::New(env, (double)handshake->second->CookiesRejected()));
+
+    return result;
+}
+
+Napi::Value SetPeerKey(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    Napi::Buffer<uint8_t> key = info[3].As<Napi::Buffer<uint8_t>>();
+    bool isServer = info[4].As<Napi::Boolean>().Value();
+
+    if (key.Length() != NANOSOCKETS_SECURE_KEY_SIZE) {
+        Napi::TypeError::New(env, "Expected a 32-byte key").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    NanoAddress address = { 0 };
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    secureSessions[socket][address].reset(new SecureSession(key.Data(), isServer));
+
+    return env.Undefined();
+}
+
+Napi::Value RemovePeerKey(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+
+    auto sessions = secureSessions.find(socket);
+
+    if (sessions != secureSessions.end()) {
+        NanoAddress address = { 0 };
+        nanosockets_address_set_ip(&address, ip.c_str());
+        address.port = port;
+
+        sessions->second.erase(address);
+    }
+
+    return env.Undefined();
+}
+
+Napi::Value SendSecure(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    Napi::Buffer<uint8_t> buffer = info[3].As<Napi::Buffer<uint8_t>>();
+
+    NanoAddress address = { 0 };
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    SecureSession* session = FindSecureSession(socket, &address);
+
+    if (session == NULL) {
+        Napi::TypeError::New(env, "No key set for this peer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uint8_t* packet = (uint8_t*)alloca(buffer.Length() + NANOSOCKETS_SECURE_OVERHEAD);
+    memcpy(packet + NANOSOCKETS_SECURE_HEADER_SIZE, buffer.Data(), buffer.Length());
+
+    int packetLength = session->Seal(packet, buffer.Length());
+
+    if (packetLength < 0)
+        return Napi::Number::New(env, packetLength);
+
+    int sendResult = nanosockets_send(socket, &address, packet, packetLength);
+
+    if (sendResult >= 0)
+        nanosockets_capture_record(socket, CAPTURE_SENT, &address, packet, packetLength);
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value SendSecureBatch(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    Napi::Array buffers = info[3].As<Napi::Array>();
+    uint32_t count = buffers.Length();
+
+    NanoAddress address = { 0 };
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    SecureSession* session = FindSecureSession(socket, &address);
+
+    if (session == NULL) {
+        Napi::TypeError::New(env, "No key set for this peer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // Seal every datagram into one slab and hand the whole batch to the kernel
+
+    std::vector<Napi::Buffer<uint8_t>> payloads(count);
+    std::vector<size_t> offsets(count);
+    std::vector<const uint8_t*> data(count);
+    std::vector<int> lengths(count);
+    size_t slabLength = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        payloads[i] = buffers.Get(i).As<Napi::Buffer<uint8_t>>();
+        offsets[i] = slabLength;
+        slabLength += payloads[i].Length() + NANOSOCKETS_SECURE_OVERHEAD;
+    }
+
+    std::vector<uint8_t> slab(slabLength);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t* packet = slab.data() + offsets[i];
+        memcpy(packet + NANOSOCKETS_SECURE_HEADER_SIZE, payloads[i].Data(), payloads[i].Length());
+
+        lengths[i] = session->Seal(packet, payloads[i].Length());
+        data[i] = packet;
+
+        if (lengths[i] < 0)
+            return Napi::Number::New(env, -1);
+    }
+
+    int sendResult = nanosockets_send_batch(socket, &address, data.data(), lengths.data(), count);
+
+    for (int i = 0; i < sendResult; i++)
+        nanosockets_capture_record(socket, CAPTURE_SENT, &address, data[i], lengths[i]);
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value ReceiveSecure(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    int bufferSize = info[1].As<Napi::Number>().Int32Value();
+
+    uint8_t* buffer = (uint8_t*)alloca(bufferSize);
+    NanoAddress address;
+    int receiveResult;
+    int payloadLength = -1;
+
+    // Packets from peers without a key, forged or replayed packets are dropped
+
+    while ((receiveResult = nanosockets_receive(socket, &address, buffer, bufferSize)) >= 0) {
+        nanosockets_capture_record(socket, CAPTURE_RECEIVED, &address, buffer, receiveResult);
+
+        SecureSession* session = FindSecureSession(socket, &address);
+
+        if (session != NULL && (payloadLength = session->Open(buffer, receiveResult)) >= 0)
+            break;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+
+    if (receiveResult < 0) {
+        result.Set("status", Napi::Number::New(env, receiveResult));
+        result.Set("data", Napi::Buffer<uint8_t>::New(env, 0));
+        return result;
+    }
+
+    result.Set("status", Napi::Number::New(env, payloadLength));
+    result.Set("data", Napi::Buffer<uint8_t>::Copy(env, buffer + NANOSOCKETS_SECURE_HEADER_SIZE, payloadLength));
+
+    char ip[INET6_ADDRSTRLEN];
+    nanosockets_address_get_ip(&address, ip, sizeof(ip));
+
+    result.Set("address", Napi::String::New(env, ip));
+    result.Set("port", Napi::Number::New(env, address.port));
+
+    return result;
+}
+
+Napi::Value ReceiveSecureBatch(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    int bufferSize = info[1].As<Napi::Number>().Int32Value();
+    int count = info[2].As<Napi::Number>().Int32Value();
+
+    if (count < 1 || count > NANOSOCKETS_BATCH_SIZE)
+        count = NANOSOCKETS_BATCH_SIZE;
+
+    // Receive the batch into one slab and decrypt every datagram in place
+
+    std::vector<uint8_t> slab((size_t)bufferSize * count);
+    std::vector<uint8_t*> buffers(count);
+    std::vector<int> lengths(count, bufferSize);
+    std::vector<NanoAddress> addresses(count);
+
+    for (int i = 0; i < count; i++)
+        buffers[i] = slab.data() + (size_t)bufferSize * i;
+
+    int receiveResult = nanosockets_receive_batch(socket, addresses.data(), buffers.data(), lengths.data(), count);
+
+    Napi::Array results = Napi::Array::New(env);
+    uint32_t resultCount = 0;
+
+    for (int i = 0; i < receiveResult; i++) {
+        nanosockets_capture_record(socket, CAPTURE_RECEIVED, &addresses[i], buffers[i], lengths[i]);
+
+        SecureSession* session = FindSecureSession(socket, &addresses[i]);
+        int payloadLength;
+
+        if (session == NULL || (payloadLength = session->Open(buffers[i], lengths[i])) < 0)
+            continue;
+
+        char ip[INET6_ADDRSTRLEN];
+        nanosockets_address_get_ip(&addresses[i], ip, sizeof(ip));
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("status", Napi::Number::New(env, payloadLength));
+        result.Set("data", Napi::Buffer<uint8_t>::Copy(env, buffers[i] + NANOSOCKETS_SECURE_HEADER_SIZE, payloadLength));
+        result.Set("address", Napi::String::New(env, ip));
+        result.Set("port", Napi::Number::New(env, addresses[i].port));
+
+        results.Set(resultCount++, result);
+    }
+
+    return results;
+}
+
+class BitBufferWrap : public Napi::ObjectWrap<BitBufferWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "BitBuffer", {
+            InstanceMethod("clear", &BitBufferWrap::Clear),
+            InstanceMethod("addBits", &BitBufferWrap::AddBits),
+            InstanceMethod("readBits", &BitBufferWrap::ReadBits),
+            InstanceMethod("peekBits", &BitBufferWrap::PeekBits),
+            InstanceMethod("addBool", &BitBufferWrap::AddBool),
+            InstanceMethod("readBool", &BitBufferWrap::ReadBool),
+            InstanceMethod("addByte", &BitBufferWrap::AddByte),
+            InstanceMethod("readByte", &BitBufferWrap::ReadByte),
+            InstanceMethod("addShort", &BitBufferWrap::AddShort),
+            InstanceMethod("readShort", &BitBufferWrap::ReadShort),
+            InstanceMethod("addUInt", &BitBufferWrap::AddUInt),
+            InstanceMethod("readUInt", &BitBufferWrap::ReadUInt),
+            InstanceMethod("addInt", &BitBufferWrap::AddInt),
+            InstanceMethod("readInt", &BitBufferWrap::ReadInt),
+            InstanceMethod("addFloat", &BitBufferWrap::AddFloat),
+            InstanceMethod("readFloat", &BitBufferWrap::ReadFloat),
+            InstanceMethod("addQuantized", &BitBufferWrap::AddQuantized),
+            InstanceMethod("readQuantized", &BitBufferWrap::ReadQuantized),
+            InstanceMethod("addString", &BitBufferWrap::AddString),
+            InstanceMethod("readString", &BitBufferWrap::ReadString),
+            InstanceMethod("setStringTable", &BitBufferWrap::SetStringTable),
+            InstanceMethod("toBuffer", &BitBufferWrap::ToBuffer),
+            InstanceMethod("fromBuffer", &BitBufferWrap::FromBuffer),
+            InstanceAccessor("length", &BitBufferWrap::GetLength, nullptr),
+            InstanceAccessor("isFinished", &BitBufferWrap::GetIsFinished, nullptr)
+        });
+    }
+
+    BitBufferWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<BitBufferWrap>(info),
+          buffer(info.Length() > 0 ? info[0].As<Napi::Number>().Uint32Value() : NANOSOCKETS_BITBUFFER_DEFAULT_CAPACITY) {
+    }
+
+    BitBuffer& Buffer() { return buffer; }
+
+private:
+    Napi::Value Written(const Napi::CallbackInfo& info, bool status) {
+        if (!status)
+            Napi::RangeError::New(info.Env(), "BitBuffer overflow").ThrowAsJavaScriptException();
+
+        return info.This();
+    }
+
+    Napi::Value Read(const Napi::CallbackInfo& info, Napi::Value value) {
+        if (buffer.HasError()) {
+            Napi::RangeError::New(info.Env(), "BitBuffer read out of range").ThrowAsJavaScriptException();
+            return info.Env().Null();
+        }
+
+        return value;
+    }
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        buffer.Clear();
+        return info.This();
+    }
+
+    Napi::Value AddBits(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.Add(info[0].As<Napi::Number>().Uint32Value(), info[1].As<Napi::Number>().Int32Value()));
+    }
+
+    Napi::Value ReadBits(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), buffer.Read(info[0].As<Napi::Number>().Int32Value())));
+    }
+
+    Napi::Value PeekBits(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), buffer.Peek(info[0].As<Napi::Number>().Int32Value()));
+    }
+
+    Napi::Value AddBool(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.Add(info[0].As<Napi::Boolean>().Value() ? 1 : 0, 1));
+    }
+
+    Napi::Value ReadBool(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Boolean::New(info.Env(), buffer.Read(1) == 1));
+    }
+
+    Napi::Value AddByte(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.Add(info[0].As<Napi::Number>().Uint32Value(), 8));
+    }
+
+    Napi::Value ReadByte(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), buffer.Read(8)));
+    }
+
+    Napi::Value AddShort(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.Add((uint16_t)info[0].As<Napi::Number>().Int32Value(), 16));
+    }
+
+    Napi::Value ReadShort(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), (int16_t)buffer.Read(16)));
+    }
+
+    Napi::Value AddUInt(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.AddUInt(info[0].As<Napi::Number>().Uint32Value()));
+    }
+
+    Napi::Value ReadUInt(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), buffer.ReadUInt()));
+    }
+
+    Napi::Value AddInt(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.AddInt(info[0].As<Napi::Number>().Int32Value()));
+    }
+
+    Napi::Value ReadInt(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), buffer.ReadInt()));
+    }
+
+    Napi::Value AddFloat(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.AddFloat(info[0].As<Napi::Number>().FloatValue()));
+    }
+
+    Napi::Value ReadFloat(const Napi::CallbackInfo& info) {
+        return Read(info, Napi::Number::New(info.Env(), buffer.ReadFloat()));
+    }
+
+    Napi::Value AddQuantized(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.AddQuantized(
+            info[0].As<Napi::Number>().FloatValue(),
+            info[1].As<Napi::Number>().FloatValue(),
+            info[2].As<Napi::Number>().FloatValue(),
+            info[3].As<Napi::Number>().Int32Value()
+        ));
+    }
+
+    Napi::Value ReadQuantized(const Napi::CallbackInfo& info) {
+        float value = buffer.ReadQuantized(
+            info[0].As<Napi::Number>().FloatValue(),
+            info[1].As<Napi::Number>().FloatValue(),
+            info[2].As<Napi::Number>().Int32Value()
+        );
+
+        return Read(info, Napi::Number::New(info.Env(), value));
+    }
+
+    Napi::Value AddString(const Napi::CallbackInfo& info) {
+        return Written(info, buffer.AddString(info[0].As<Napi::String>().Utf8Value()));
+    }
+
+    Napi::Value ReadString(const Napi::CallbackInfo& info) {
+        std::string value = buffer.ReadString();
+        return Read(info, Napi::String::New(info.Env(), value));
+    }
+
+    Napi::Value SetStringTable(const Napi::CallbackInfo& info) {
+        Napi::Array array = info[0].As<Napi::Array>();
+        std::vector<std::string> strings(array.Length());
+
+        for (uint32_t i = 0; i < array.Length(); i++)
+            strings[i] = array.Get(i).As<Napi::String>().Utf8Value();
+
+        buffer.SetStringTable(strings);
+        return info.This();
+    }
+
+    Napi::Value ToBuffer(const Napi::CallbackInfo& info) {
+        return Napi::Buffer<uint8_t>::Copy(info.Env(), buffer.Data(), buffer.Length());
+    }
+
+    Napi::Value FromBuffer(const Napi::CallbackInfo& info) {
+        Napi::Buffer<uint8_t> source = info[0].As<Napi::Buffer<uint8_t>>();
+
+        if (source.Length() > buffer.Capacity()) {
+            Napi::RangeError::New(info.Env(), "Buffer exceeds BitBuffer capacity").ThrowAsJavaScriptException();
+            return info.Env().Null();
+        }
+
+        memcpy(buffer.Data(), source.Data(), source.Length());
+        buffer.SetLength(source.Length());
+        return info.This();
+    }
+
+    Napi::Value GetLength(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), buffer.Length());
+    }
+
+    Napi::Value GetIsFinished(const Napi::CallbackInfo& info) {
+        return Napi::Boolean::New(info.Env(), buffer.IsFinished());
+    }
+
+    BitBuffer buffer;
+};
+
+Napi::Value SendBitBuffer(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    BitBuffer& bitBuffer = BitBufferWrap::Unwrap(info[3].As<Napi::Object>())->Buffer();
+
+    NanoAddress address;
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    int sendResult = nanosockets_send(socket, &address, bitBuffer.Data(), bitBuffer.Length());
+
+    if (sendResult >= 0)
+        nanosockets_capture_record(socket, CAPTURE_SENT, &address, bitBuffer.Data(), bitBuffer.Length());
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value ReceiveBitBuffer(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    BitBuffer& bitBuffer = BitBufferWrap::Unwrap(info[1].As<Napi::Object>())->Buffer();
+
+    NanoAddress address;
+
+    int receiveResult = nanosockets_receive(socket, &address, bitBuffer.Data(), bitBuffer.Capacity());
+    nanosockets_capture_record(socket, CAPTURE_RECEIVED, &address, bitBuffer.Data(), receiveResult);
+    bitBuffer.SetLength(receiveResult > 0 ? receiveResult : 0);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("status", Napi::Number::New(env, receiveResult));
+
+    if (receiveResult >= 0) {
+        char ip[INET6_ADDRSTRLEN];
+        nanosockets_address_get_ip(&address, ip, sizeof(ip));
+
+        result.Set("address", Napi::String::New(env, ip));
+        result.Set("port", Napi::Number::New(env, address.port));
+    }
+
+    return result;
+}
+
+class DeltaCodecWrap : public Napi::ObjectWrap<DeltaCodecWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "DeltaCodec", {
+            InstanceMethod("encode", &DeltaCodecWrap::Encode),
+            InstanceMethod("decode", &DeltaCodecWrap::Decode),
+            InstanceMethod("acknowledge", &DeltaCodecWrap::Acknowledge)
+        });
+    }
+
+    DeltaCodecWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<DeltaCodecWrap>(info) {
+    }
+
+    DeltaCodec& Codec() { return codec; }
+
+private:
+    Napi::Value Encode(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Buffer<uint8_t> snapshot = info[0].As<Napi::Buffer<uint8_t>>();
+        std::vector<uint8_t> output(DeltaCodec::MaximumEncodedSize(snapshot.Length()));
+
+        int length = codec.Encode(snapshot.Data(), snapshot.Length(), output.data());
+
+        if (length < 0) {
+            Napi::RangeError::New(env, "Snapshot is too large").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        return Napi::Buffer<uint8_t>::Copy(env, output.data(), length);
+    }
+
+    Napi::Value Decode(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Buffer<uint8_t> packet = info[0].As<Napi::Buffer<uint8_t>>();
+
+        const Snapshot* snapshot = codec.Decode(packet.Data(), packet.Length());
+
+        if (snapshot == NULL)
+            return env.Null();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("sequence", Napi::Number::New(env, snapshot->sequence));
+        result.Set("snapshot", Napi::Buffer<uint8_t>::Copy(env, snapshot->data.data(), snapshot->data.size()));
+
+        return result;
+    }
+
+    Napi::Value Acknowledge(const Napi::CallbackInfo& info) {
+        codec.Acknowledge(info[0].As<Napi::Number>().Uint32Value());
+        return info.Env().Undefined();
+    }
+
+    DeltaCodec codec;
+};
+
+Napi::Value SendSnapshot(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string ip = info[1].As<Napi::String>();
+    uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+    DeltaCodec& codec = DeltaCodecWrap::Unwrap(info[3].As<Napi::Object>())->Codec();
+    Napi::Buffer<uint8_t> snapshot = info[4].As<Napi::Buffer<uint8_t>>();
+
+    // Encode into a reusable scratch buffer and send it as is
+
+    static std::vector<uint8_t> packet;
+    packet.resize(DeltaCodec::MaximumEncodedSize(snapshot.Length()));
+
+    int length = codec.Encode(snapshot.Data(), snapshot.Length(), packet.data());
+
+    if (length < 0)
+        return Napi::Number::New(env, length);
+
+    NanoAddress address;
+    nanosockets_address_set_ip(&address, ip.c_str());
+    address.port = port;
+
+    int sendResult = nanosockets_send(socket, &address, packet.data(), length);
+
+    if (sendResult >= 0)
+        nanosockets_capture_record(socket, CAPTURE_SENT, &address, packet.data(), length);
+
+    return Napi::Number::New(env, sendResult);
+}
+
+void EmitSendQueueEvent(Napi::Env env, Napi::FunctionReference& callback, SendQueueEvent event, bool fromEventLoop) {
+    if (event == SENDQUEUE_NONE || callback.IsEmpty())
+        return;
+
+    Napi::HandleScope scope(env);
+    Napi::String name = Napi::String::New(env, event == SENDQUEUE_HIGH_WATERMARK ? "high" : "low");
+
+    if (fromEventLoop)
+        callback.MakeCallback(env.Global(), { name });
+    else
+        callback.Call({ name });
+}
+
+void UpdateSendQueuePoll(SendQueueEntry* entry);
+
+void DrainSendQueue(SendQueueEntry* entry) {
+    SendQueueEvent event;
+
+    {
+        std::lock_guard<std::mutex> lock(socketMutex);
+
+        entry->queue->Flush();
+        UpdateSendQueuePoll(entry);
+        event = entry->queue->TakeEvent();
+    }
+
+    EmitSendQueueEvent(Napi::Env(entry->env), entry->callback, event, true);
+}
+
+void OnSendQueueWritable(uv_poll_t* handle, int status, int events) {
+    DrainSendQueue((SendQueueEntry*)handle->data);
+}
+
+void OnSendQueueBackoff(uv_timer_t* handle) {
+    SendQueueEntry* entry = (SendQueueEntry*)handle->data;
+
+    entry->timing = false;
+    DrainSendQueue(entry);
+}
+
+void UpdateSendQueuePoll(SendQueueEntry* entry) {
+    // Only wait while there is something to drain. A socket out of kernel
+    // buffers still polls as writable, so that case retries on a timer instead
+
+    bool waitWritable = !entry->queue->IsEmpty() && !entry->queue->NeedsBackoff();
+    bool waitTimer = !entry->queue->IsEmpty() && entry->queue->NeedsBackoff();
+
+    if (waitWritable && !entry->polling) {
+        uv_poll_start(entry->poll, UV_WRITABLE, OnSendQueueWritable);
+        entry->polling = true;
+    } else if (!waitWritable && entry->polling) {
+        uv_poll_stop(entry->poll);
+        entry->polling = false;
+    }
+
+    if (waitTimer && !entry->timing) {
+        uv_timer_start(entry->timer, OnSendQueueBackoff, NANOSOCKETS_SENDQUEUE_BACKOFF_MILLISECONDS, 0);
+        entry->timing = true;
+    } else if (!waitTimer && entry->timing) {
+        uv_timer_stop(entry->timer);
+        entry->timing = false;
+    }
+}
+
+Napi::Value CreateSendQueue(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    uint32_t capacity = info[1].As<Napi::Number>().Uint32Value();
+    uint32_t highWatermark = info[2].As<Napi::Number>().Uint32Value();
+    uint32_t lowWatermark = info[3].As<Napi::Number>().Uint32Value();
+
+    if (lowWatermark > highWatermark || highWatermark > capacity) {
+        Napi::RangeError::New(env, "Expected lowWatermark <= highWatermark <= capacity").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uv_loop_t* loop = NULL;
+    napi_get_uv_event_loop(env, &loop);
+
+    CloseSendQueue(socket);
+
+    std::unique_ptr<SendQueueEntry> entry(new SendQueueEntry());
+    entry->queue.reset(new SendQueue(socket, capacity, highWatermark, lowWatermark));
+    entry->poll = new uv_poll_t();
+    entry->timer = new uv_timer_t();
+    entry->polling = false;
+    entry->timing = false;
+    entry->env = env;
+
+    if (info[4].IsFunction())
+        entry->callback = Napi::Persistent(info[4].As<Napi::Function>());
+
+    if (uv_poll_init_socket(loop, entry->poll, (uv_os_sock_t)socket) != 0) {
+        delete entry->poll;
+        delete entry->timer;
+        Napi::Error::New(env, "Failed to watch socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    uv_timer_init(loop, entry->timer);
+
+    entry->poll->data = entry.get();
+    entry->timer->data = entry.get();
+    sendQueues[socket] = std::move(entry);
+
+    return env.Undefined();
+}
+
+Napi::Value DestroySendQueue(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    CloseSendQueue(socket);
+
+    return env.Undefined();
+}
+
+Napi::Value SendQueued(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    SendQueueEntry* entry;
+    SendQueueEvent event;
+    int sendResult;
+
+    {
+        std::lock_guard<std::mutex> lock(socketMutex);
+        NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+        std::string ip = info[1].As<Napi::String>();
+        uint16_t port = info[2].As<Napi::Number>().Uint32Value();
+        Napi::Buffer<uint8_t> buffer = info[3].As<Napi::Buffer<uint8_t>>();
+
+        auto found = sendQueues.find(socket);
+
+        if (found == sendQueues.end()) {
+            Napi::TypeError::New(env, "Send queue is not enabled for this socket").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        entry = found->second.get();
+
+        NanoAddress address;
+        nanosockets_address_set_ip(&address, ip.c_str());
+        address.port = port;
+
+        // The queue records the datagram to a capture once it is actually sent
+
+        sendResult = entry->queue->Send(&address, buffer.Data(), buffer.Length());
+
+        UpdateSendQueuePoll(entry);
+        event = entry->queue->TakeEvent();
+    }
+
+    // The lock is released so the handler may call back into the socket
+
+    EmitSendQueueEvent(env, entry->callback, event, false);
+
+    return Napi::Number::New(env, sendResult);
+}
+
+Napi::Value GetSendQueueStats(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    auto entry = sendQueues.find(socket);
+
+    if (entry == sendQueues.end()) {
+        Napi::TypeError::New(env, "Send queue is not enabled for this socket").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    SendQueue* queue = entry->second->queue.get();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("queuedBytes", Napi::Number::New(env, (double)queue->QueuedBytes()));
+    result.Set("queuedPackets", Napi::Number::New(env, (double)queue->QueuedPackets()));
+    result.Set("dropped", Napi::Number::New(env, (double)queue->Dropped()));
+
+    return result;
+}
+
+Napi::Value StartCapture(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+    std::string path = info[1].As<Napi::String>();
+    std::string format = info[2].As<Napi::String>();
+
+    if (format != "native" && format != "pcap") {
+        Napi::TypeError::New(env, "Expected capture format 'native' or 'pcap'").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool started = nanosockets_capture_start(socket, path.c_str(), format == "pcap" ? CAPTURE_PCAP : CAPTURE_NATIVE);
+    return Napi::Number::New(env, started ? NANOSOCKETS_STATUS_OK : NANOSOCKETS_STATUS_ERROR);
+}
+
+Napi::Value StopCapture(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(socketMutex);
+    Napi::Env env = info.Env();
+    NanoSocket socket = info[0].As<Napi::Number>().Int64Value();
+
+    nanosockets_capture_stop(socket);
+
+    return env.Undefined();
+}
+
 Napi::Value IsEqual(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     NanoAddress* address1 = Napi::ObjectWrap<NanoAddress>::Unwrap(info[0].As<Napi::Object>());
@@ -372,9 +1623,47 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set(Napi::String::New(env, "getOption"), Napi::Function::New(env, GetOption));
     exports.Set(Napi::String::New(env, "setNonBlocking"), Napi::Function::New(env, SetNonBlocking));
     exports.Set(Napi::String::New(env, "setDontFragment"), Napi::Function::New(env, SetDontFragment));
+    exports.Set(Napi::String::New(env, "setReuseAddress"), Napi::Function::New(env, SetReuseAddress));
+    exports.Set(Napi::String::New(env, "joinMulticast"), Napi::Function::New(env, JoinMulticast));
+    exports.Set(Napi::String::New(env, "leaveMulticast"), Napi::Function::New(env, LeaveMulticast));
+    exports.Set(Napi::String::New(env, "setMulticastTTL"), Napi::Function::New(env, SetMulticastTTL));
+    exports.Set(Napi::String::New(env, "setMulticastLoopback"), Napi::Function::New(env, SetMulticastLoopback));
+    exports.Set(Napi::String::New(env, "setMulticastInterface"), Napi::Function::New(env, SetMulticastInterface));
     exports.Set(Napi::String::New(env, "poll"), Napi::Function::New(env, Poll));
     exports.Set(Napi::String::New(env, "send"), Napi::Function::New(env, Send));
     exports.Set(Napi::String::New(env, "receive"), Napi::Function::New(env, Receive));
+    exports.Set(Napi::String::New(env, "createConnected"), Napi::Function::New(env, CreateConnected));
+    exports.Set(Napi::String::New(env, "sendConnected"), Napi::Function::New(env, SendConnected));
+    exports.Set(Napi::String::New(env, "sendConnectedBatch"), Napi::Function::New(env, SendConnectedBatch));
+    exports.Set(Napi::String::New(env, "receiveConnected"), Napi::Function::New(env, ReceiveConnected));
+    exports.Set(Napi::String::New(env, "createDispatcher"), Napi::Function::New(env, CreateDispatcher));
+    exports.Set(Napi::String::New(env, "destroyDispatcher"), Napi::Function::New(env, DestroyDispatcher));
+    exports.Set(Napi::String::New(env, "getDispatcherStats"), Napi::Function::New(env, GetDispatcherStats));
+    exports.Set(Napi::String::New(env, "attachFilter"), Napi::Function::New(env, AttachFilter));
+    exports.Set(Napi::String::New(env, "detachFilter"), Napi::Function::New(env, DetachFilter));
+    exports.Set(Napi::String::New(env, "getStats"), Napi::Function::New(env, GetStats));
+    exports.Set(Napi::String::New(env, "enableHandshake"), Napi::Function::New(env, EnableHandshake));
+    exports.Set(Napi::String::New(env, "disableHandshake"), Napi::Function::New(env, DisableHandshake));
+    exports.Set(Napi::String::New(env, "receiveVerified"), Napi::Function::New(env, ReceiveVerified));
+    exports.Set(Napi::String::New(env, "forgetPeer"), Napi::Function::New(env, ForgetPeer));
+    exports.Set(Napi::String::New(env, "getHandshakeStats"), Napi::Function::New(env, GetHandshakeStats));
+    exports.Set(Napi::String::New(env, "setPeerKey"), Napi::Function::New(env, SetPeerKey));
+    exports.Set(Napi::String::New(env, "removePeerKey"), Napi::Function::New(env, RemovePeerKey));
+    exports.Set(Napi::String::New(env, "sendSecure"), Napi::Function::New(env, SendSecure));
+    exports.Set(Napi::String::New(env, "sendSecureBatch"), Napi::Function::New(env, SendSecureBatch));
+    exports.Set(Napi::String::New(env, "receiveSecure"), Napi::Function::New(env, ReceiveSecure));
+    exports.Set(Napi::String::New(env, "receiveSecureBatch"), Napi::Function::New(env, ReceiveSecureBatch));
+    exports.Set(Napi::String::New(env, "BitBuffer"), BitBufferWrap::Define(env));
+    exports.Set(Napi::String::New(env, "sendBitBuffer"), Napi::Function::New(env, SendBitBuffer));
+    exports.Set(Napi::String::New(env, "receiveBitBuffer"), Napi::Function::New(env, ReceiveBitBuffer));
+    exports.Set(Napi::String::New(env, "DeltaCodec"), DeltaCodecWrap::Define(env));
+    exports.Set(Napi::String::New(env, "sendSnapshot"), Napi::Function::New(env, SendSnapshot));
+    exports.Set(Napi::String::New(env, "createSendQueue"), Napi::Function::New(env, CreateSendQueue));
+    exports.Set(Napi::String::New(env, "destroySendQueue"), Napi::Function::New(env, DestroySendQueue));
+    exports.Set(Napi::String::New(env, "sendQueued"), Napi::Function::New(env, SendQueued));
+    exports.Set(Napi::String::New(env, "getSendQueueStats"), Napi::Function::New(env, GetSendQueueStats));
+    exports.Set(Napi::String::New(env, "startCapture"), Napi::Function::New(env, StartCapture));
+    exports.Set(Napi::String::New(env, "stopCapture"), Napi::Function::New(env, StopCapture));
     exports.Set(Napi::String::New(env, "isEqual"), Napi::Function::New(env, IsEqual));
     exports.Set(Napi::String::New(env, "setIP"), Napi::Function::New(env, SetIP));
     exports.Set(Napi::String::New(env, "getIP"), Napi::Function::New(env, GetIP));
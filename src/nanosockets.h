@@ -59,6 +59,7 @@
 #endif
 
 #define NANOSOCKETS_HOSTNAME_SIZE 1025
+#define NANOSOCKETS_BATCH_SIZE 64
 
 // API
 
@@ -73,6 +74,12 @@ extern "C" {
 		NANOSOCKETS_STATUS_ERROR = -1
 	} NanoStatus;
 
+	typedef enum _NanoFamily {
+		NANOSOCKETS_FAMILY_IPV4 = 1,
+		NANOSOCKETS_FAMILY_IPV6 = 2,
+		NANOSOCKETS_FAMILY_ALL = 3
+	} NanoFamily;
+
 	typedef struct _NanoAddress {
 		union {
 			struct in6_addr ipv6;
@@ -115,8 +122,34 @@ extern "C" {
 
 	NANOSOCKETS_API int nanosockets_receive_offset(NanoSocket, NanoAddress*, uint8_t*, int, int);
 
+	NANOSOCKETS_API NanoSocket nanosockets_create_connected(NanoSocket, const NanoAddress*, int, int);
+
+	NANOSOCKETS_API int nanosockets_send_connected(NanoSocket, const uint8_t*, int);
+
+	NANOSOCKETS_API int nanosockets_send_batch(NanoSocket, const NanoAddress*, const uint8_t**, const int*, int);
+
+	NANOSOCKETS_API int nanosockets_send_connected_batch(NanoSocket, const uint8_t**, const int*, int);
+
+	NANOSOCKETS_API int nanosockets_receive_connected(NanoSocket, uint8_t*, int);
+
+	NANOSOCKETS_API int nanosockets_receive_batch(NanoSocket, NanoAddress*, uint8_t**, int*, int);
+
+	NANOSOCKETS_API NanoStatus nanosockets_set_reuseaddress(NanoSocket, uint8_t);
+
+	NANOSOCKETS_API NanoStatus nanosockets_multicast_join(NanoSocket, const NanoAddress*, const NanoAddress*, uint32_t);
+
+	NANOSOCKETS_API NanoStatus nanosockets_multicast_leave(NanoSocket, const NanoAddress*, const NanoAddress*, uint32_t);
+
+	NANOSOCKETS_API NanoStatus nanosockets_multicast_set_ttl(NanoSocket, int, NanoFamily);
+
+	NANOSOCKETS_API NanoStatus nanosockets_multicast_set_loopback(NanoSocket, uint8_t, NanoFamily);
+
+	NANOSOCKETS_API NanoStatus nanosockets_multicast_set_interface(NanoSocket, uint32_t, NanoFamily);
+
 	NANOSOCKETS_API NanoStatus nanosockets_address_get(NanoSocket, NanoAddress*);
 
+	NANOSOCKETS_API NanoStatus nanosockets_address_get_peer(NanoSocket, NanoAddress*);
+
 	NANOSOCKETS_API NanoStatus nanosockets_address_is_equal(const NanoAddress*, const NanoAddress*);
 
 	NANOSOCKETS_API NanoStatus nanosockets_address_set_ip(NanoAddress*, const char*);
@@ -162,6 +195,86 @@ extern "C" {
 		return 0;
 	}
 
+	inline static int nanosockets_address_is_ipv4(const NanoAddress* address) {
+		return address->ipv4.ffff == 0xFFFF && nanosockets_array_is_zeroed(address->ipv4.zeros, sizeof(address->ipv4.zeros)) == 0;
+	}
+
+	inline static void nanosockets_address_to_storage(const NanoAddress* address, struct sockaddr_storage* destination) {
+		memset(destination, 0, sizeof(struct sockaddr_storage));
+
+		if (nanosockets_address_is_ipv4(address)) {
+			struct sockaddr_in* socketAddress = (struct sockaddr_in*)destination;
+
+			socketAddress->sin_family = AF_INET;
+			socketAddress->sin_addr = address->ipv4.ip;
+			socketAddress->sin_port = NANOSOCKETS_HOST_TO_NET_16(address->port);
+		} else {
+			struct sockaddr_in6* socketAddress = (struct sockaddr_in6*)destination;
+
+			socketAddress->sin6_family = AF_INET6;
+			socketAddress->sin6_addr = address->ipv6;
+			socketAddress->sin6_port = NANOSOCKETS_HOST_TO_NET_16(address->port);
+		}
+	}
+
+	inline static NanoStatus nanosockets_multicast_membership(NanoSocket socket, const NanoAddress* group, const NanoAddress* source, uint32_t interfaceIndex, uint8_t join) {
+		int level = nanosockets_address_is_ipv4(group) ? IPPROTO_IP : IPPROTO_IPV6;
+
+		// Protocol-independent membership options (RFC 3678) take an interface
+		// index for both families and support source-specific joins
+
+		#ifdef MCAST_JOIN_GROUP
+			if (source != NULL) {
+				struct group_source_req request;
+
+				memset(&request, 0, sizeof(request));
+				request.gsr_interface = interfaceIndex;
+				nanosockets_address_to_storage(group, &request.gsr_group);
+				nanosockets_address_to_storage(source, &request.gsr_source);
+
+				if (setsockopt(socket, level, join ? MCAST_JOIN_SOURCE_GROUP : MCAST_LEAVE_SOURCE_GROUP, (const char*)&request, sizeof(request)) != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+			} else {
+				struct group_req request;
+
+				memset(&request, 0, sizeof(request));
+				request.gr_interface = interfaceIndex;
+				nanosockets_address_to_storage(group, &request.gr_group);
+
+				if (setsockopt(socket, level, join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, (const char*)&request, sizeof(request)) != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+			}
+		#else
+			if (source != NULL)
+				return NANOSOCKETS_STATUS_ERROR;
+
+			if (level == IPPROTO_IP) {
+				struct ip_mreq request = { 0 };
+
+				// ip_mreq selects the interface by address, not by index
+
+				if (interfaceIndex != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+
+				request.imr_multiaddr = group->ipv4.ip;
+				request.imr_interface.s_addr = NANOSOCKETS_HOST_TO_NET_32(INADDR_ANY);
+
+				if (setsockopt(socket, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, (const char*)&request, sizeof(request)) != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+			} else {
+				struct ipv6_mreq request = { 0 };
+
+				request.ipv6mr_multiaddr = group->ipv6;
+				request.ipv6mr_interface = interfaceIndex;
+
+				if (setsockopt(socket, IPPROTO_IPV6, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, (const char*)&request, sizeof(request)) != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+			}
+		#endif
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
 	inline static void nanosockets_address_extract(NanoAddress* address, const struct sockaddr_storage* source) {
 		if (source->ss_family == AF_INET) {
 			struct sockaddr_in* socketAddress = (struct sockaddr_in*)source;
@@ -374,6 +487,246 @@ extern "C" {
 		return nanosockets_receive(socket, address, buffer + offset, bufferLength);
 	}
 
+	// Sharing the listener's port requires the address reuse option on both
+	// sockets, so the listener's options are changed as a side effect. Linux
+	// allows duplicate unicast UDP binds with SO_REUSEADDR and BSD/macOS with
+	// SO_REUSEPORT, both delivering to the most specific match. Windows lets
+	// SO_REUSEADDR steal the port outright, so it is not supported there
+
+	NanoSocket nanosockets_create_connected(NanoSocket listener, const NanoAddress* address, int sendBufferSize, int receiveBufferSize) {
+		#ifdef _WIN32
+			return -1;
+		#else
+			#ifdef __linux__
+				const int reuseOption = SO_REUSEADDR;
+			#else
+				const int reuseOption = SO_REUSEPORT;
+			#endif
+
+			NanoAddress localAddress = { 0 };
+			int reuse = 1;
+
+			if (nanosockets_address_get(listener, &localAddress) != NANOSOCKETS_STATUS_OK)
+				return -1;
+
+			if (setsockopt(listener, SOL_SOCKET, reuseOption, (const char*)&reuse, sizeof(reuse)) != 0)
+				return -1;
+
+			NanoSocket socketHandle = nanosockets_create(sendBufferSize, receiveBufferSize);
+
+			if (socketHandle > -1) {
+				if (setsockopt(socketHandle, SOL_SOCKET, reuseOption, (const char*)&reuse, sizeof(reuse)) != 0)
+					goto destroy;
+
+				if (nanosockets_bind(socketHandle, &localAddress) != 0)
+					goto destroy;
+
+				if (nanosockets_connect(socketHandle, address) != 0)
+					goto destroy;
+
+				goto create;
+
+				destroy:
+
+				nanosockets_destroy(&socketHandle);
+
+				return -1;
+			}
+
+			create:
+
+			return socketHandle;
+		#endif
+	}
+
+	int nanosockets_send_connected(NanoSocket socket, const uint8_t* buffer, int bufferLength) {
+		return send(socket, (const char*)buffer, bufferLength, 0);
+	}
+
+	int nanosockets_send_batch(NanoSocket socket, const NanoAddress* address, const uint8_t** buffers, const int* bufferLengths, int count) {
+		#if defined(__linux__) && defined(_GNU_SOURCE)
+			struct mmsghdr messages[NANOSOCKETS_BATCH_SIZE];
+			struct iovec vectors[NANOSOCKETS_BATCH_SIZE];
+			struct sockaddr_in6 socketAddress = { 0 };
+			int sent = 0;
+
+			if (address != NULL) {
+				socketAddress.sin6_family = AF_INET6;
+				socketAddress.sin6_addr = address->ipv6;
+				socketAddress.sin6_port = NANOSOCKETS_HOST_TO_NET_16(address->port);
+			}
+
+			while (sent < count) {
+				int batch = count - sent < NANOSOCKETS_BATCH_SIZE ? count - sent : NANOSOCKETS_BATCH_SIZE;
+
+				memset(messages, 0, sizeof(struct mmsghdr) * batch);
+
+				for (int i = 0; i < batch; i++) {
+					vectors[i].iov_base = (void*)buffers[sent + i];
+					vectors[i].iov_len = bufferLengths[sent + i];
+					messages[i].msg_hdr.msg_iov = &vectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+
+					if (address != NULL) {
+						messages[i].msg_hdr.msg_name = &socketAddress;
+						messages[i].msg_hdr.msg_namelen = sizeof(socketAddress);
+					}
+				}
+
+				int result = sendmmsg(socket, messages, batch, 0);
+
+				if (result <= 0)
+					return sent > 0 ? sent : result;
+
+				sent += result;
+
+				if (result < batch)
+					break;
+			}
+
+			return sent;
+		#else
+			int sent = 0;
+
+			for (int i = 0; i < count; i++) {
+				if (nanosockets_send(socket, address, buffers[i], bufferLengths[i]) < 0)
+					return sent > 0 ? sent : -1;
+
+				sent++;
+			}
+
+			return sent;
+		#endif
+	}
+
+	int nanosockets_send_connected_batch(NanoSocket socket, const uint8_t** buffers, const int* bufferLengths, int count) {
+		return nanosockets_send_batch(socket, NULL, buffers, bufferLengths, count);
+	}
+
+	int nanosockets_receive_connected(NanoSocket socket, uint8_t* buffer, int bufferLength) {
+		return recv(socket, (char*)buffer, bufferLength, 0);
+	}
+
+	// Lengths hold the buffer sizes on entry and the received sizes on return.
+	// Waits for the first datagram as a single receive would and then takes
+	// only what is already queued
+
+	int nanosockets_receive_batch(NanoSocket socket, NanoAddress* addresses, uint8_t** buffers, int* lengths, int count) {
+		#if defined(__linux__) && defined(_GNU_SOURCE)
+			struct mmsghdr messages[NANOSOCKETS_BATCH_SIZE];
+			struct iovec vectors[NANOSOCKETS_BATCH_SIZE];
+			struct sockaddr_storage addressStorage[NANOSOCKETS_BATCH_SIZE];
+
+			if (count > NANOSOCKETS_BATCH_SIZE)
+				count = NANOSOCKETS_BATCH_SIZE;
+
+			memset(messages, 0, sizeof(struct mmsghdr) * count);
+
+			for (int i = 0; i < count; i++) {
+				vectors[i].iov_base = buffers[i];
+				vectors[i].iov_len = lengths[i];
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+				messages[i].msg_hdr.msg_name = &addressStorage[i];
+				messages[i].msg_hdr.msg_namelen = sizeof(addressStorage[i]);
+			}
+
+			int received = recvmmsg(socket, messages, count, MSG_WAITFORONE, NULL);
+
+			for (int i = 0; i < received; i++) {
+				lengths[i] = messages[i].msg_len;
+
+				if (addresses != NULL)
+					nanosockets_address_extract(&addresses[i], &addressStorage[i]);
+			}
+
+			return received;
+		#else
+			int received = 0;
+
+			while (received < count) {
+				if (received > 0 && nanosockets_poll(socket, 0) <= 0)
+					break;
+
+				int result = nanosockets_receive(socket, addresses != NULL ? &addresses[received] : NULL, buffers[received], lengths[received]);
+
+				if (result < 0)
+					return received > 0 ? received : result;
+
+				lengths[received++] = result;
+			}
+
+			return received;
+		#endif
+	}
+
+	NanoStatus nanosockets_set_reuseaddress(NanoSocket socket, uint8_t state) {
+		int reuseAddress = state;
+
+		if (setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuseAddress, sizeof(reuseAddress)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
+	NanoStatus nanosockets_multicast_join(NanoSocket socket, const NanoAddress* group, const NanoAddress* source, uint32_t interfaceIndex) {
+		return nanosockets_multicast_membership(socket, group, source, interfaceIndex, 1);
+	}
+
+	NanoStatus nanosockets_multicast_leave(NanoSocket socket, const NanoAddress* group, const NanoAddress* source, uint32_t interfaceIndex) {
+		return nanosockets_multicast_membership(socket, group, source, interfaceIndex, 0);
+	}
+
+	// The dual-stack socket may send to both IPv4 and IPv6 groups, so the
+	// options below are applied to each requested family and fail if any of
+	// them does
+
+	NanoStatus nanosockets_multicast_set_ttl(NanoSocket socket, int ttl, NanoFamily family) {
+		if ((family & NANOSOCKETS_FAMILY_IPV4) && setsockopt(socket, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		if ((family & NANOSOCKETS_FAMILY_IPV6) && setsockopt(socket, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, (const char*)&ttl, sizeof(ttl)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
+	NanoStatus nanosockets_multicast_set_loopback(NanoSocket socket, uint8_t state, NanoFamily family) {
+		int loopback = state;
+
+		if ((family & NANOSOCKETS_FAMILY_IPV4) && setsockopt(socket, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loopback, sizeof(loopback)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		if ((family & NANOSOCKETS_FAMILY_IPV6) && setsockopt(socket, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, (const char*)&loopback, sizeof(loopback)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
+	NanoStatus nanosockets_multicast_set_interface(NanoSocket socket, uint32_t interfaceIndex, NanoFamily family) {
+		if (family & NANOSOCKETS_FAMILY_IPV4) {
+			// Only Linux accepts an interface index for IPv4, elsewhere the
+			// option takes the interface address
+
+			#ifdef __linux__
+				struct ip_mreqn request;
+
+				memset(&request, 0, sizeof(request));
+				request.imr_ifindex = interfaceIndex;
+
+				if (setsockopt(socket, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&request, sizeof(request)) != 0)
+					return NANOSOCKETS_STATUS_ERROR;
+			#else
+				return NANOSOCKETS_STATUS_ERROR;
+			#endif
+		}
+
+		if ((family & NANOSOCKETS_FAMILY_IPV6) && setsockopt(socket, IPPROTO_IPV6, IPV6_MULTICAST_IF, (const char*)&interfaceIndex, sizeof(interfaceIndex)) != 0)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
 	NanoStatus nanosockets_address_get(NanoSocket socket, NanoAddress* address) {
 		struct sockaddr_storage addressStorage = { 0 };
 		socklen_t addressLength = sizeof(addressStorage);
@@ -386,6 +739,18 @@ extern "C" {
 		return NANOSOCKETS_STATUS_OK;
 	}
 
+	NanoStatus nanosockets_address_get_peer(NanoSocket socket, NanoAddress* address) {
+		struct sockaddr_storage addressStorage = { 0 };
+		socklen_t addressLength = sizeof(addressStorage);
+
+		if (getpeername(socket, (struct sockaddr*)&addressStorage, &addressLength) == -1)
+			return NANOSOCKETS_STATUS_ERROR;
+
+		nanosockets_address_extract(address, &addressStorage);
+
+		return NANOSOCKETS_STATUS_OK;
+	}
+
 	NanoStatus nanosockets_address_is_equal(const NanoAddress* left, const NanoAddress* right) {
 		if (memcmp(left, right, sizeof(struct in6_addr)) == 0 && left->port == right->port)
 			return NANOSOCKETS_STATUS_OK;
@@ -413,7 +778,7 @@ extern "C" {
 	}
 
 	NanoStatus nanosockets_address_get_ip(const NanoAddress* address, char* ip, int ipLength) {
-		if (address->ipv4.ffff == 0xFFFF && nanosockets_array_is_zeroed(address->ipv4.zeros, sizeof(address->ipv4.zeros)) == 0) {
+		if (nanosockets_address_is_ipv4(address)) {
 			if (inet_ntop(AF_INET, &address->ipv4.ip, ip, ipLength) == NULL)
 				return NANOSOCKETS_STATUS_ERROR;
 		} else if (inet_ntop(AF_INET6, &address->ipv6, ip, ipLength) == NULL) {
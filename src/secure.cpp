@@ -0,0 +1,234 @@
+#include <string.h>
+#include <utility>
+
+#include <openssl/crypto.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "secure.h"
+
+#define NANOSOCKETS_SECURE_NONCE_SIZE 12
+
+static uint64_t nanosockets_secure_read64(const uint8_t* buffer) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < 8; i++)
+        value |= (uint64_t)buffer[i] << (8 * i);
+
+    return value;
+}
+
+SecureSession::SecureSession(const uint8_t key[NANOSOCKETS_SECURE_KEY_SIZE], bool isServer)
+    : confirmations(0), sendDirection(isServer ? 1 : 0), receiveDirection(isServer ? 0 : 1),
+      sendCounter(0), rejected(0) {
+    uint8_t sessionKey[NANOSOCKETS_SECURE_KEY_SIZE];
+
+    memcpy(staticKey, key, NANOSOCKETS_SECURE_KEY_SIZE);
+
+    // Contexts are keyed once and only re-nonced per packet, which keeps the
+    // per-datagram cost to the cipher itself. The receive side is keyed once
+    // the peer's salt is known
+
+    sealContext = EVP_CIPHER_CTX_new();
+    spareContext = EVP_CIPHER_CTX_new();
+    current = Receiver();
+    current.context = EVP_CIPHER_CTX_new();
+    candidate = Receiver();
+    candidate.context = EVP_CIPHER_CTX_new();
+
+    if (RAND_bytes(sendSalt, NANOSOCKETS_SECURE_SALT_SIZE) != 1 || !Derive(sessionKey, sendSalt, sendDirection) ||
+        EVP_EncryptInit_ex(sealContext, EVP_chacha20_poly1305(), NULL, sessionKey, NULL) != 1)
+        sendCounter = UINT64_MAX;
+
+    OPENSSL_cleanse(sessionKey, sizeof(sessionKey));
+}
+
+SecureSession::~SecureSession() {
+    OPENSSL_cleanse(staticKey, sizeof(staticKey));
+    EVP_CIPHER_CTX_free(sealContext);
+    EVP_CIPHER_CTX_free(spareContext);
+    EVP_CIPHER_CTX_free(current.context);
+    EVP_CIPHER_CTX_free(candidate.context);
+}
+
+void SecureSession::Nonce(uint8_t nonce[NANOSOCKETS_SECURE_NONCE_SIZE], uint32_t direction, uint64_t counter) const {
+    for (int i = 0; i < 4; i++)
+        nonce[i] = (uint8_t)(direction >> (8 * i));
+
+    for (int i = 0; i < 8; i++)
+        nonce[4 + i] = (uint8_t)(counter >> (8 * i));
+}
+
+bool SecureSession::Derive(uint8_t key[NANOSOCKETS_SECURE_KEY_SIZE], const uint8_t* salt, uint32_t direction) const {
+    uint8_t input[NANOSOCKETS_SECURE_SALT_SIZE + 4];
+    unsigned int keyLength = 0;
+
+    memcpy(input, salt, NANOSOCKETS_SECURE_SALT_SIZE);
+
+    for (int i = 0; i < 4; i++)
+        input[NANOSOCKETS_SECURE_SALT_SIZE + i] = (uint8_t)(direction >> (8 * i));
+
+    return HMAC(EVP_sha256(), staticKey, NANOSOCKETS_SECURE_KEY_SIZE, input, sizeof(input), key, &keyLength) != NULL &&
+        keyLength == NANOSOCKETS_SECURE_KEY_SIZE;
+}
+
+int SecureSession::Seal(uint8_t* buffer, int length) {
+    if (sendCounter == UINT64_MAX)
+        return -1;
+
+    uint64_t counter = ++sendCounter;
+    uint8_t nonce[NANOSOCKETS_SECURE_NONCE_SIZE];
+    uint8_t* payload = buffer + NANOSOCKETS_SECURE_HEADER_SIZE;
+    int outputLength = 0;
+
+    memcpy(buffer, sendSalt, NANOSOCKETS_SECURE_SALT_SIZE);
+
+    for (int i = 0; i < 8; i++)
+        buffer[NANOSOCKETS_SECURE_SALT_SIZE + i] = (uint8_t)(counter >> (8 * i));
+
+    Nonce(nonce, sendDirection, counter);
+
+    if (EVP_EncryptInit_ex(sealContext, NULL, NULL, NULL, nonce) != 1 ||
+        EVP_EncryptUpdate(sealContext, NULL, &outputLength, buffer, NANOSOCKETS_SECURE_HEADER_SIZE) != 1 ||
+        EVP_EncryptUpdate(sealContext, payload, &outputLength, payload, length) != 1 ||
+        EVP_EncryptFinal_ex(sealContext, payload + outputLength, &outputLength) != 1 ||
+        EVP_CIPHER_CTX_ctrl(sealContext, EVP_CTRL_AEAD_GET_TAG, NANOSOCKETS_SECURE_TAG_SIZE, payload + length) != 1)
+        return -1;
+
+    return length + NANOSOCKETS_SECURE_OVERHEAD;
+}
+
+bool SecureSession::Decrypt(EVP_CIPHER_CTX* context, uint8_t* buffer, int payloadLength, uint64_t counter) const {
+    uint8_t nonce[NANOSOCKETS_SECURE_NONCE_SIZE];
+    uint8_t* payload = buffer + NANOSOCKETS_SECURE_HEADER_SIZE;
+    int outputLength = 0;
+
+    Nonce(nonce, receiveDirection, counter);
+
+    return EVP_DecryptInit_ex(context, NULL, NULL, NULL, nonce) == 1 &&
+        EVP_DecryptUpdate(context, NULL, &outputLength, buffer, NANOSOCKETS_SECURE_HEADER_SIZE) == 1 &&
+        EVP_DecryptUpdate(context, payload, &outputLength, payload, payloadLength) == 1 &&
+        EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_SET_TAG, NANOSOCKETS_SECURE_TAG_SIZE, payload + payloadLength) == 1 &&
+        EVP_DecryptFinal_ex(context, payload + outputLength, &outputLength) == 1;
+}
+
+void SecureSession::Receiver::Reset(uint64_t salt) {
+    this->salt = salt;
+    keyed = true;
+    highestCounter = 0;
+    memset(window, 0, sizeof(window));
+}
+
+// The window keeps one word more than it covers, as in RFC 6479, so the word
+// of the oldest accepted counter is never the one recycled for the newest
+
+bool SecureSession::Receiver::IsReplay(uint64_t counter) const {
+    if (counter == 0)
+        return true;
+
+    if (counter > highestCounter)
+        return false;
+
+    uint64_t age = highestCounter - counter;
+
+    if (age >= NANOSOCKETS_SECURE_WINDOW_SIZE)
+        return true;
+
+    return (window[(counter / 64) % NANOSOCKETS_SECURE_WINDOW_WORDS] >> (counter % 64)) & 1;
+}
+
+void SecureSession::Receiver::Accept(uint64_t counter) {
+    const uint64_t words = NANOSOCKETS_SECURE_WINDOW_WORDS;
+
+    if (counter > highestCounter) {
+        // Clear the words that slid out of the window since the last packet
+
+        uint64_t first = highestCounter / 64 + 1;
+        uint64_t last = counter / 64;
+
+        if (last - highestCounter / 64 >= words)
+            memset(window, 0, sizeof(window));
+        else {
+            for (uint64_t word = first; word <= last; word++)
+                window[word % words] = 0;
+        }
+
+        highestCounter = counter;
+    }
+
+    window[(counter / 64) % words] |= 1ULL << (counter % 64);
+}
+
+// Only authenticated packets may advance a window
+
+int SecureSession::Open(Receiver& receiver, uint8_t* buffer, int payloadLength, uint64_t counter) {
+    if (receiver.IsReplay(counter) || !Decrypt(receiver.context, buffer, payloadLength, counter)) {
+        rejected++;
+
+        return -1;
+    }
+
+    receiver.Accept(counter);
+
+    return payloadLength;
+}
+
+int SecureSession::Open(uint8_t* buffer, int length) {
+    if (length < NANOSOCKETS_SECURE_OVERHEAD) {
+        rejected++;
+
+        return -1;
+    }
+
+    uint64_t salt = nanosockets_secure_read64(buffer);
+    uint64_t counter = nanosockets_secure_read64(buffer + NANOSOCKETS_SECURE_SALT_SIZE);
+    int payloadLength = length - NANOSOCKETS_SECURE_OVERHEAD;
+
+    if (current.keyed && salt == current.salt) {
+        int result = Open(current, buffer, payloadLength, counter);
+
+        // Any authentic packet under the current salt shows the peer still
+        // uses it, so the candidate has to start confirming again
+
+        if (result >= 0)
+            confirmations = 0;
+
+        return result;
+    }
+
+    if (candidate.keyed && salt == candidate.salt) {
+        int result = Open(candidate, buffer, payloadLength, counter);
+
+        if (result >= 0 && ++confirmations >= NANOSOCKETS_SECURE_CONFIRMATIONS) {
+            std::swap(current, candidate);
+            confirmations = 0;
+        }
+
+        return result;
+    }
+
+    // A salt not seen before is tried under a freshly derived key. Once it
+    // authenticates it takes the candidate slot, or the current one if no
+    // session exists yet, and never displaces the current session directly
+
+    uint8_t sessionKey[NANOSOCKETS_SECURE_KEY_SIZE];
+    bool keyed = counter != 0 && Derive(sessionKey, buffer, receiveDirection) &&
+        EVP_DecryptInit_ex(spareContext, EVP_chacha20_poly1305(), NULL, sessionKey, NULL) == 1;
+
+    OPENSSL_cleanse(sessionKey, sizeof(sessionKey));
+
+    if (!keyed || !Decrypt(spareContext, buffer, payloadLength, counter)) {
+        rejected++;
+
+        return -1;
+    }
+
+    Receiver& receiver = current.keyed ? candidate : current;
+
+    std::swap(receiver.context, spareContext);
+    receiver.Reset(salt);
+    receiver.Accept(counter);
+    confirmations = &receiver == &candidate ? 1 : 0;
+
+    return payloadLength;
+}
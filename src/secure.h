@@ -0,0 +1,83 @@
+#ifndef NANOSOCKETS_SECURE_H
+#define NANOSOCKETS_SECURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <openssl/evp.h>
+
+// Per-peer ChaCha20-Poly1305 session. Each datagram is framed as
+// [salt:8][counter:8][ciphertext][tag:16]. Every session picks a random salt
+// and encrypts under a key derived from the static key, the salt and the
+// sending direction, so re-registering a key after a reconnect or restart
+// never reuses a nonce. The nonce is the packet counter, which doubles as the
+// replay-protection sequence number.
+
+#define NANOSOCKETS_SECURE_KEY_SIZE 32
+#define NANOSOCKETS_SECURE_SALT_SIZE 8
+#define NANOSOCKETS_SECURE_COUNTER_SIZE 8
+#define NANOSOCKETS_SECURE_HEADER_SIZE (NANOSOCKETS_SECURE_SALT_SIZE + NANOSOCKETS_SECURE_COUNTER_SIZE)
+#define NANOSOCKETS_SECURE_TAG_SIZE 16
+#define NANOSOCKETS_SECURE_OVERHEAD (NANOSOCKETS_SECURE_HEADER_SIZE + NANOSOCKETS_SECURE_TAG_SIZE)
+#define NANOSOCKETS_SECURE_WINDOW_SIZE 1024
+#define NANOSOCKETS_SECURE_WINDOW_WORDS (NANOSOCKETS_SECURE_WINDOW_SIZE / 64 + 1)
+#define NANOSOCKETS_SECURE_CONFIRMATIONS 4
+
+class SecureSession {
+public:
+    SecureSession(const uint8_t key[NANOSOCKETS_SECURE_KEY_SIZE], bool isServer);
+    ~SecureSession();
+
+    SecureSession(const SecureSession&) = delete;
+    SecureSession& operator=(const SecureSession&) = delete;
+
+    // Encrypts length bytes at buffer + NANOSOCKETS_SECURE_HEADER_SIZE in place
+    // and fills in the salt, counter and tag. Buffer must have room for the
+    // overhead. Returns the framed length, or -1 when the session is exhausted.
+    int Seal(uint8_t* buffer, int length);
+
+    // Authenticates and decrypts a framed datagram in place. Returns the
+    // plaintext length, starting at buffer + NANOSOCKETS_SECURE_HEADER_SIZE,
+    // or -1 if the packet is forged, malformed or replayed. A packet under a
+    // new salt that authenticates opens a candidate session next to the
+    // current one, each with its own replay window. The candidate becomes
+    // current after NANOSOCKETS_SECURE_CONFIRMATIONS packets in a row with no
+    // packet under the current salt in between, and the session it replaces
+    // stays as the candidate, so a replayed old session can never lock out the
+    // one the peer is using.
+    int Open(uint8_t* buffer, int length);
+
+    uint64_t Rejected() const { return rejected; }
+
+private:
+    struct Receiver {
+        EVP_CIPHER_CTX* context;
+        uint64_t salt;
+        bool keyed;
+        uint64_t highestCounter;
+        uint64_t window[NANOSOCKETS_SECURE_WINDOW_WORDS];
+
+        void Reset(uint64_t salt);
+        bool IsReplay(uint64_t counter) const;
+        void Accept(uint64_t counter);
+    };
+
+    int Open(Receiver& receiver, uint8_t* buffer, int payloadLength, uint64_t counter);
+    void Nonce(uint8_t nonce[12], uint32_t direction, uint64_t counter) const;
+    bool Derive(uint8_t key[NANOSOCKETS_SECURE_KEY_SIZE], const uint8_t* salt, uint32_t direction) const;
+    bool Decrypt(EVP_CIPHER_CTX* context, uint8_t* buffer, int payloadLength, uint64_t counter) const;
+
+    uint8_t staticKey[NANOSOCKETS_SECURE_KEY_SIZE];
+    EVP_CIPHER_CTX* sealContext;
+    EVP_CIPHER_CTX* spareContext;
+    uint8_t sendSalt[NANOSOCKETS_SECURE_SALT_SIZE];
+    Receiver current;
+    Receiver candidate;
+    uint32_t confirmations;
+    uint32_t sendDirection;
+    uint32_t receiveDirection;
+    uint64_t sendCounter;
+    uint64_t rejected;
+};
+
+#endif // NANOSOCKETS_SECURE_H
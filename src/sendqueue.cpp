@@ -0,0 +1,124 @@
+#include <errno.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+#endif
+
+#include "capture.h"
+#include "sendqueue.h"
+
+bool nanosockets_would_block(void) {
+    #ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    #else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    #endif
+}
+
+bool nanosockets_no_buffers(void) {
+    #ifdef _WIN32
+        return WSAGetLastError() == WSAENOBUFS;
+    #else
+        return errno == ENOBUFS;
+    #endif
+}
+
+SendQueue::SendQueue(NanoSocket socket, size_t capacity, size_t highWatermark, size_t lowWatermark)
+    : socket(socket), capacity(capacity), highWatermark(highWatermark), lowWatermark(lowWatermark),
+      queuedBytes(0), dropped(0), aboveHighWatermark(false), backoff(false), pendingEvent(SENDQUEUE_NONE) {
+}
+
+// Sends one datagram. On failure, retry is set when the kernel pushed back
+// and the datagram should be kept, and backoff records which kind of push
+// back it was
+
+bool SendQueue::Transmit(const NanoAddress* address, const uint8_t* buffer, int length, bool* retry) {
+    if (nanosockets_send(socket, address, buffer, length) >= 0) {
+        nanosockets_capture_record(socket, CAPTURE_SENT, address, buffer, length);
+        backoff = false;
+
+        return true;
+    }
+
+    backoff = nanosockets_no_buffers();
+    *retry = backoff || nanosockets_would_block();
+
+    return false;
+}
+
+int SendQueue::Send(const NanoAddress* address, const uint8_t* buffer, int length) {
+    // Keep ordering: nothing bypasses datagrams that are already waiting
+
+    if (datagrams.empty()) {
+        bool retry = false;
+
+        if (Transmit(address, buffer, length, &retry))
+            return length;
+
+        if (!retry) {
+            dropped++;
+
+            return -1;
+        }
+    }
+
+    if (queuedBytes + length > capacity) {
+        dropped++;
+
+        return -1;
+    }
+
+    datagrams.emplace_back();
+
+    QueuedDatagram& datagram = datagrams.back();
+
+    datagram.hasAddress = address != NULL;
+
+    if (address != NULL)
+        datagram.address = *address;
+
+    datagram.data.assign(buffer, buffer + length);
+    queuedBytes += length;
+
+    Update();
+
+    return length;
+}
+
+void SendQueue::Flush() {
+    while (!datagrams.empty()) {
+        QueuedDatagram& datagram = datagrams.front();
+        bool retry = false;
+
+        if (!Transmit(datagram.hasAddress ? &datagram.address : NULL, datagram.data.data(), (int)datagram.data.size(), &retry)) {
+            if (retry)
+                break;
+
+            dropped++;
+        }
+
+        queuedBytes -= datagram.data.size();
+        datagrams.pop_front();
+    }
+
+    Update();
+}
+
+void SendQueue::Update() {
+    if (!aboveHighWatermark && queuedBytes >= highWatermark) {
+        aboveHighWatermark = true;
+        pendingEvent = SENDQUEUE_HIGH_WATERMARK;
+    } else if (aboveHighWatermark && queuedBytes <= lowWatermark) {
+        aboveHighWatermark = false;
+        pendingEvent = SENDQUEUE_LOW_WATERMARK;
+    }
+}
+
+SendQueueEvent SendQueue::TakeEvent() {
+    SendQueueEvent event = pendingEvent;
+
+    pendingEvent = SENDQUEUE_NONE;
+
+    return event;
+}
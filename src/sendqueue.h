@@ -0,0 +1,71 @@
+#ifndef NANOSOCKETS_SENDQUEUE_H
+#define NANOSOCKETS_SENDQUEUE_H
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "nanosockets.h"
+
+// Bounded per-socket queue for datagrams the kernel could not accept. Sends
+// go straight to the socket while the queue is empty; once the send buffer is
+// full they are queued until the socket reports it is writable again. When the
+// kernel is out of buffers instead (ENOBUFS), the socket still reports itself
+// writable, so the queue asks for a timed retry rather than a writable poll.
+// Datagrams are recorded to an active capture when they actually leave.
+
+#define NANOSOCKETS_SENDQUEUE_BACKOFF_MILLISECONDS 1
+
+enum SendQueueEvent {
+    SENDQUEUE_NONE = 0,
+    SENDQUEUE_HIGH_WATERMARK = 1,
+    SENDQUEUE_LOW_WATERMARK = 2
+};
+
+struct QueuedDatagram {
+    NanoAddress address;
+    bool hasAddress;
+    std::vector<uint8_t> data;
+};
+
+class SendQueue {
+public:
+    SendQueue(NanoSocket socket, size_t capacity, size_t highWatermark, size_t lowWatermark);
+
+    // Returns the number of bytes sent or queued, or -1 if the datagram was
+    // dropped because of a socket error or because the queue is full
+    int Send(const NanoAddress* address, const uint8_t* buffer, int length);
+
+    // Sends queued datagrams until the kernel pushes back or the queue is empty
+    void Flush();
+
+    // Returns the watermark crossed since the last call, if any
+    SendQueueEvent TakeEvent();
+
+    bool IsEmpty() const { return datagrams.empty(); }
+    bool NeedsBackoff() const { return backoff; }
+    size_t QueuedBytes() const { return queuedBytes; }
+    size_t QueuedPackets() const { return datagrams.size(); }
+    uint64_t Dropped() const { return dropped; }
+
+private:
+    bool Transmit(const NanoAddress* address, const uint8_t* buffer, int length, bool* retry);
+    void Update();
+
+    NanoSocket socket;
+    size_t capacity;
+    size_t highWatermark;
+    size_t lowWatermark;
+    std::deque<QueuedDatagram> datagrams;
+    size_t queuedBytes;
+    uint64_t dropped;
+    bool aboveHighWatermark;
+    bool backoff;
+    SendQueueEvent pendingEvent;
+};
+
+bool nanosockets_would_block(void);
+bool nanosockets_no_buffers(void);
+
+#endif // NANOSOCKETS_SENDQUEUE_H
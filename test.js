@@ -0,0 +1,335 @@
+const assert = require('assert');
+const { UDP, Address, BitBuffer, DeltaCodec } = require('./');
+
+UDP.initialize();
+
+const bufferSize = 1500;
+const key = Buffer.alloc(32, 7);
+
+// A plain relay sits between a secure client and server so captured
+// datagrams can be replayed to the server later
+
+const clientAddress = Address.createFromIpPort('::1', 5101);
+const relayAddress = Address.createFromIpPort('::1', 5102);
+const serverAddress = Address.createFromIpPort('::1', 5103);
+
+const client = UDP.create(bufferSize * 64, bufferSize * 64);
+const relay = UDP.create(bufferSize * 64, bufferSize * 64);
+const server = UDP.create(bufferSize * 64, bufferSize * 64);
+
+for (const [socket, address] of [[client, clientAddress], [relay, relayAddress], [server, serverAddress]]) {
+    assert.strictEqual(UDP.bind(socket, address), 0);
+    assert.strictEqual(UDP.setNonBlocking(socket), 0);
+}
+
+UDP.setPeerKey(client, relayAddress, key, false);
+UDP.setPeerKey(server, relayAddress, key, true);
+
+const captured = [];
+
+function forward(datagram) {
+    UDP.send(relay, serverAddress, datagram);
+    assert.ok(UDP.poll(server, 1000) > 0);
+    return UDP.receiveSecure(server, bufferSize).bytesReceived;
+}
+
+function deliver(message) {
+    UDP.sendSecure(client, relayAddress, message);
+    assert.ok(UDP.poll(relay, 1000) > 0);
+
+    const { bytesReceived } = UDP.receive(relay, bufferSize);
+    captured.push(bytesReceived.data);
+
+    return forward(bytesReceived.data);
+}
+
+// Fill the whole 1024-packet window so old counters share storage words with
+// the newest ones
+
+for (let i = 1; i <= 1100; i++) {
+    const message = Buffer.from(`packet ${i}`);
+    const received = deliver(message);
+
+    assert.strictEqual(received.status, message.length);
+    assert.ok(received.data.equals(message));
+}
+
+// Replays are dropped, so the next fresh packet is the one returned
+
+for (const counter of [1, 2, 63, 64, 65, 76, 77, 128, 1023, 1024, 1099, 1100]) {
+    const fresh = Buffer.from(`after replay of ${counter}`);
+
+    UDP.send(relay, serverAddress, captured[counter - 1]);
+
+    const received = deliver(fresh);
+
+    assert.strictEqual(received.status, fresh.length, `counter ${counter} was accepted twice`);
+    assert.ok(received.data.equals(fresh));
+}
+
+// Registering the same key again must not reuse nonces, and the server must
+// follow the new client session while rejecting replays from the old one
+
+UDP.setPeerKey(client, relayAddress, key, false);
+
+const restarted = deliver(Buffer.from('packet 1'));
+
+assert.strictEqual(restarted.data.toString(), 'packet 1');
+assert.ok(!captured[captured.length - 1].subarray(16).equals(captured[0].subarray(16)));
+
+UDP.send(relay, serverAddress, captured[1099]);
+
+const afterOldSession = deliver(Buffer.from('new session'));
+
+assert.strictEqual(afterOldSession.data.toString(), 'new session');
+
+// A restarted server has no record of earlier sessions, so it cannot tell a
+// replayed one from a reconnecting client. Replays must never displace the
+// session the client is using, and each is delivered at most once
+
+const oldSession = [];
+
+for (let i = 0; i < 8; i++) {
+    deliver(Buffer.from(`old ${i}`));
+    oldSession.push(captured[captured.length - 1]);
+}
+
+UDP.setPeerKey(server, relayAddress, key, true);
+UDP.setPeerKey(client, relayAddress, key, false);
+
+for (let i = 0; i < 8; i++)
+    assert.strictEqual(deliver(Buffer.from(`live ${i}`)).data.toString(), `live ${i}`);
+
+for (const datagram of [...oldSession, ...oldSession])
+    UDP.send(relay, serverAddress, datagram);
+
+const replayed = new Set();
+
+while (UDP.poll(server, 100) > 0) {
+    const { bytesReceived } = UDP.receiveSecure(server, bufferSize);
+
+    if (bytesReceived.status < 0)
+        break;
+
+    const text = bytesReceived.data.toString();
+
+    assert.ok(text.startsWith('old ') && !replayed.has(text), `${text} was accepted twice`);
+    replayed.add(text);
+}
+
+for (let i = 8; i < 24; i++)
+    assert.strictEqual(deliver(Buffer.from(`live ${i}`)).data.toString(), `live ${i}`);
+
+for (const datagram of oldSession)
+    UDP.send(relay, serverAddress, datagram);
+
+assert.strictEqual(deliver(Buffer.from('still live')).data.toString(), 'still live');
+
+// BitBuffer packets round-trip through the socket without a copy
+
+const writer = new BitBuffer(bufferSize);
+const reader = new BitBuffer(bufferSize);
+
+function transfer() {
+    UDP.sendBitBuffer(relay, serverAddress, writer);
+    assert.ok(UDP.poll(server, 1000) > 0);
+
+    const { bytesReceived } = UDP.receiveBitBuffer(server, reader);
+
+    assert.strictEqual(bytesReceived.status, writer.length);
+}
+
+const unsigned = [0, 1, 127, 128, 16383, 16384, 2 ** 31, 2 ** 32 - 1];
+const signed = [0, -1, 1, -64, 64, -(2 ** 31), 2 ** 31 - 1];
+const quantized = [-1000, -0.5, 123.456, 999.999, 5000];
+const step = 2000 / (2 ** 20 - 1);
+const table = ['player', 'enemy'];
+
+writer.setStringTable(table);
+reader.setStringTable(table);
+writer.clear();
+
+for (const value of unsigned)
+    writer.addUInt(value);
+
+for (const value of signed)
+    writer.addInt(value);
+
+for (const value of quantized)
+    writer.addQuantized(value, -1000, 1000, 20);
+
+writer.addString('enemy').addString('custom').addString('custom').addString('player');
+
+transfer();
+
+for (const value of unsigned)
+    assert.strictEqual(reader.readUInt(), value);
+
+for (const value of signed)
+    assert.strictEqual(reader.readInt(), value);
+
+for (const value of quantized)
+    assert.ok(Math.abs(reader.readQuantized(-1000, 1000, 20) - Math.min(value, 1000)) <= step);
+
+for (const value of ['enemy', 'custom', 'custom', 'player'])
+    assert.strictEqual(reader.readString(), value);
+
+// Known strings cost a flag bit and a one-byte index
+
+writer.clear().addString('enemy');
+
+assert.strictEqual(writer.length, 2);
+
+// A short packet received after a long one only exposes its own bytes. The
+// length is known in whole bytes, so isFinished waits for the padding too
+
+writer.clear();
+
+for (let i = 0; i < 200; i++)
+    writer.addByte(0xFF);
+
+transfer();
+
+writer.clear().addBits(5, 3);
+
+transfer();
+
+assert.strictEqual(reader.length, 1);
+assert.strictEqual(reader.readBits(3), 5);
+assert.ok(!reader.isFinished);
+assert.strictEqual(reader.readBits(5), 0);
+assert.ok(reader.isFinished);
+assert.throws(() => reader.readBits(1), RangeError);
+
+// DeltaCodec encodes against the newest acknowledged baseline and falls back
+// to a full snapshot whenever it has no usable one
+
+const DELTA_FULL = 0;
+const DELTA_XOR = 1;
+const DELTA_HEADER_SIZE = 5;
+
+const encoder = new DeltaCodec();
+const decoder = new DeltaCodec();
+const states = [];
+
+function snapshot(version) {
+    const state = Buffer.alloc(256, 1);
+
+    state.writeUInt32LE(version, 64);
+    state[200] = version & 0xFF;
+    states[version] = state;
+
+    return state;
+}
+
+function baselineOf(packet) {
+    return packet.readUInt16LE(3);
+}
+
+function decodes(packet, version) {
+    const decoded = decoder.decode(packet);
+
+    assert.ok(decoded !== null);
+    assert.ok(decoded.snapshot.equals(states[version]));
+
+    return decoded.sequence;
+}
+
+const first = encoder.encode(snapshot(0));
+
+assert.strictEqual(first[0], DELTA_FULL);
+encoder.acknowledge(decodes(first, 0));
+
+// A lost delta does not matter, the next one is still against the acknowledged
+// baseline the receiver holds
+
+const lost = encoder.encode(snapshot(1));
+
+assert.strictEqual(lost[0], DELTA_XOR);
+assert.ok(lost.length < first.length);
+
+const afterLoss = encoder.encode(snapshot(2));
+
+assert.strictEqual(afterLoss[0], DELTA_XOR);
+assert.strictEqual(baselineOf(afterLoss), 0);
+
+const acknowledged = decodes(afterLoss, 2);
+
+// An acknowledgement that arrives after a newer one must not move the
+// baseline back
+
+const third = encoder.encode(snapshot(3));
+
+decodes(third, 3);
+encoder.acknowledge(3);
+encoder.acknowledge(acknowledged);
+
+const afterLateAck = encoder.encode(snapshot(4));
+
+assert.strictEqual(baselineOf(afterLateAck), 3);
+decodes(afterLateAck, 4);
+encoder.acknowledge(4);
+
+// An unchanged snapshot encodes as a delta with an empty body
+
+const unchanged = encoder.encode(states[4]);
+
+assert.strictEqual(unchanged[0], DELTA_XOR);
+assert.strictEqual(unchanged.length, DELTA_HEADER_SIZE + 2);
+assert.ok(decoder.decode(unchanged).snapshot.equals(states[4]));
+
+// Once the acknowledged baseline has left the sender's ring, the codec falls
+// back to a full snapshot
+
+let evicted;
+
+for (let version = 5; version <= 5 + 32; version++)
+    evicted = encoder.encode(snapshot(version));
+
+assert.strictEqual(evicted[0], DELTA_FULL);
+decodes(evicted, 37);
+
+// A delta against a baseline the receiver never decoded is rejected
+
+encoder.acknowledge(evicted.readUInt16LE(1));
+
+const missingBaseline = encoder.encode(snapshot(38));
+
+assert.strictEqual(missingBaseline[0], DELTA_XOR);
+assert.strictEqual(new DeltaCodec().decode(missingBaseline), null);
+
+// Every socket sharing a port through setReuseAddress receives its own copy
+// of a multicast datagram that is looped back to the sending host
+
+for (const group of ['239.1.2.3', 'ff12::4e53:1']) {
+    const groupAddress = Address.createFromIpPort(group, 5110);
+    const receivers = [UDP.create(bufferSize, bufferSize), UDP.create(bufferSize, bufferSize)];
+    const sender = UDP.create(bufferSize, bufferSize);
+    const message = Buffer.from(`multicast ${group}`);
+
+    for (const receiver of receivers) {
+        assert.strictEqual(UDP.setReuseAddress(receiver), 0);
+        assert.strictEqual(UDP.bind(receiver, Address.createFromIpPort('::', 5110)), 0);
+        assert.strictEqual(UDP.setNonBlocking(receiver), 0);
+        assert.strictEqual(UDP.joinMulticast(receiver, group), 0);
+    }
+
+    assert.strictEqual(UDP.setMulticastLoopback(sender, true), 0);
+    assert.strictEqual(UDP.send(sender, groupAddress, message), message.length);
+
+    for (const receiver of receivers) {
+        assert.ok(UDP.poll(receiver, 1000) > 0, `${group} was not looped back`);
+        assert.ok(UDP.receive(receiver, bufferSize).bytesReceived.data.equals(message));
+        assert.strictEqual(UDP.leaveMulticast(receiver, group), 0);
+        UDP.destroy(receiver);
+    }
+
+    UDP.destroy(sender);
+}
+
+UDP.destroy(client);
+UDP.destroy(relay);
+UDP.destroy(server);
+UDP.deinitialize();
+
+console.log('ok');
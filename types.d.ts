@@ -16,6 +16,122 @@ export interface Socket {
   // You may add specific properties or methods for the socket object as needed.
 }
 
+export interface Dispatcher {
+  handle: number;
+  workers: {
+    receiveQueue: SharedArrayBuffer;
+    sendQueue: SharedArrayBuffer;
+  }[];
+}
+
+export interface DispatcherPacket {
+  ip: Uint8Array;
+  address: string;
+  port: number;
+  data: Buffer;
+}
+
+export declare class DispatcherQueue {
+  constructor(buffer: SharedArrayBuffer);
+
+  static allocate(slots: number, slotSize: number): SharedArrayBuffer;
+
+  readonly dropped: number;
+
+  push(ip: string | Uint8Array, port: number, data: Uint8Array): boolean;
+
+  pop(): DispatcherPacket | null;
+
+  receive(timeout: number, pollInterval?: number): DispatcherPacket | null;
+}
+
+export type AddressFamily = 'ipv4' | 'ipv6' | 'all';
+
+export interface FilterOptions {
+  minimumLength?: number;
+  maximumLength?: number;
+  prefix?: Buffer;
+  prefixOffset?: number;
+  ranges?: {
+    offset: number;
+    minimum: number;
+    maximum: number;
+  }[];
+}
+
+export interface SocketStats {
+  status: number;
+  receiveQueued: number;
+  receiveBuffer: number;
+  sendQueued: number;
+  sendBuffer: number;
+  drops: number;
+}
+
+export declare class BitBuffer {
+  constructor(capacity?: number);
+
+  readonly length: number;
+
+  readonly isFinished: boolean;
+
+  clear(): this;
+
+  addBits(value: number, bits: number): this;
+
+  readBits(bits: number): number;
+
+  peekBits(bits: number): number;
+
+  addBool(value: boolean): this;
+
+  readBool(): boolean;
+
+  addByte(value: number): this;
+
+  readByte(): number;
+
+  addShort(value: number): this;
+
+  readShort(): number;
+
+  addUInt(value: number): this;
+
+  readUInt(): number;
+
+  addInt(value: number): this;
+
+  readInt(): number;
+
+  addFloat(value: number): this;
+
+  readFloat(): number;
+
+  addQuantized(value: number, minimum: number, maximum: number, bits: number): this;
+
+  readQuantized(minimum: number, maximum: number, bits: number): number;
+
+  addString(value: string): this;
+
+  readString(): string;
+
+  setStringTable(strings: string[]): this;
+
+  toBuffer(): Buffer;
+
+  fromBuffer(buffer: Buffer): this;
+}
+
+export declare class DeltaCodec {
+  constructor();
+
+  encode(snapshot: Buffer): Buffer;
+
+  decode(packet: Buffer): { sequence: number; snapshot: Buffer } | null;
+
+  acknowledge(sequence: number): void;
+}
+
 export interface UDP {
   static initialize(): void;
 
@@ -37,6 +153,18 @@ export interface UDP {
 
   static setDontFragment(socket: Socket): number;
 
+  static setReuseAddress(socket: Socket, reuseAddress?: boolean): number;
+
+  static joinMulticast(socket: Socket, group: string, source?: string | null, interfaceIndex?: number): number;
+
+  static leaveMulticast(socket: Socket, group: string, source?: string | null, interfaceIndex?: number): number;
+
+  static setMulticastTTL(socket: Socket, ttl: number, family?: AddressFamily): number;
+
+  static setMulticastLoopback(socket: Socket, loopback?: boolean, family?: AddressFamily): number;
+
+  static setMulticastInterface(socket: Socket, interfaceIndex: number, family?: AddressFamily): number;
+
   static poll(socket: Socket, timeout: number): number;
 
   static send(socket: Socket, address: Address, buffer: Buffer): number;
@@ -47,6 +175,116 @@ export interface UDP {
     buffer: Buffer;
   };
 
+  static createConnected(listener: Socket, address: Address, sendBufferSize: number, receiveBufferSize: number): Socket;
+
+  static sendConnected(socket: Socket, buffer: Buffer): number;
+
+  static sendConnectedBatch(socket: Socket, buffers: Buffer[]): number;
+
+  static receiveConnected(socket: Socket, bufferSize: number): {
+    bytesReceived: {
+      status: number;
+      data: Buffer;
+    };
+  };
+
+  static attachFilter(socket: Socket, options: FilterOptions): number;
+
+  static detachFilter(socket: Socket): number;
+
+  static getStats(socket: Socket): SocketStats;
+
+  static enableHandshake(socket: Socket, rotationSeconds?: number, maximumPeers?: number): void;
+
+  static disableHandshake(socket: Socket): void;
+
+  static receiveVerified(socket: Socket, bufferSize: number): {
+    bytesReceived: {
+      status: number;
+      data: Buffer;
+      address?: string;
+      port?: number;
+    };
+  };
+
+  static forgetPeer(socket: Socket, address: Address): void;
+
+  static getHandshakeStats(socket: Socket): {
+    peers: number;
+    challengesSent: number;
+    cookiesRejected: number;
+  };
+
+  static isChallenge(buffer: Buffer): boolean;
+
+  static createCookieEcho(challenge: Buffer, payload?: Buffer): Buffer;
+
+  static setPeerKey(socket: Socket, address: Address, key: Buffer, isServer?: boolean): void;
+
+  static removePeerKey(socket: Socket, address: Address): void;
+
+  static sendSecure(socket: Socket, address: Address, buffer: Buffer): number;
+
+  static sendSecureBatch(socket: Socket, address: Address, buffers: Buffer[]): number;
+
+  static receiveSecure(socket: Socket, bufferSize: number): {
+    bytesReceived: {
+      status: number;
+      data: Buffer;
+      address?: string;
+      port?: number;
+    };
+  };
+
+  static receiveSecureBatch(socket: Socket, bufferSize: number, count?: number): {
+    status: number;
+    data: Buffer;
+    address: string;
+    port: number;
+  }[];
+
+  static sendBitBuffer(socket: Socket, address: Address, bitBuffer: BitBuffer): number;
+
+  static receiveBitBuffer(socket: Socket, bitBuffer: BitBuffer): {
+    bytesReceived: {
+      status: number;
+      address?: string;
+      port?: number;
+    };
+  };
+
+  static sendSnapshot(socket: Socket, address: Address, codec: DeltaCodec, snapshot: Buffer): number;
+
+  static createSendQueue(
+    socket: Socket,
+    options?: { capacity?: number; highWatermark?: number; lowWatermark?: number },
+    onWatermark?: ((event: 'high' | 'low') => void) | null
+  ): void;
+
+  static destroySendQueue(socket: Socket): void;
+
+  static sendQueued(socket: Socket, address: Address, buffer: Buffer): number;
+
+  static getSendQueueStats(socket: Socket): {
+    queuedBytes: number;
+    queuedPackets: number;
+    dropped: number;
+  };
+
+  static startCapture(socket: Socket, path: string, format?: 'native' | 'pcap'): number;
+
+  static stopCapture(socket: Socket): void;
+
+  static createDispatcher(socket: Socket, workerCount: number, slots?: number, slotSize?: number): Dispatcher;
+
+  static destroyDispatcher(dispatcher: Dispatcher): void;
+
+  static getDispatcherStats(dispatcher: Dispatcher): {
+    received: number;
+    sent: number;
+    dropped: number;
+  };
+
   static getAddress(socket: Socket): Address;
 }
 